@@ -0,0 +1,503 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "cleaner.h"
+#include "org_tree.h"
+#include "org_search.h"
+#include "cipher_reader.h"
+#include "fixed_point.h"
+
+/* Times each hot path in isolation over the files bench/gen writes and
+ * prints one JSON document: per stage the calls made, items and bytes
+ * processed, throughput, per-call latency percentiles and the peak RSS of
+ * the process that ran it. Every stage group runs in its own child process
+ * so the peaks do not accumulate. */
+
+#define MAX_LATENCIES (1u << 24)
+#define FIXED_BLOCK 4096
+
+typedef struct {
+    char name[40];
+    char unit[16];          /* what items counts */
+    size_t calls;
+    size_t items;
+    size_t bytes;
+    size_t hits;            /* stage specific: matches found */
+    double seconds;         /* time spent inside the timed calls */
+    double p50_us, p90_us, p99_us, max_us;
+} StageResult;
+
+typedef struct {
+    double *us;
+    size_t len;
+    size_t cap;
+} Latencies;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static void lat_add(Latencies *l, double us) {
+    if (l->len == l->cap) {
+        if (l->cap >= MAX_LATENCIES) return;   /* enough samples for percentiles */
+        size_t cap = l->cap ? l->cap * 2 : 1024;
+        double *tmp = (double *)realloc(l->us, cap * sizeof(double));
+        if (!tmp) return;
+        l->us = tmp;
+        l->cap = cap;
+    }
+    l->us[l->len++] = us;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const Latencies *l, int pct) {
+    if (l->len == 0) return 0;
+    size_t i = (l->len * (size_t)pct) / 100;
+    return l->us[i < l->len ? i : l->len - 1];
+}
+
+static void stage_finish(StageResult *r, Latencies *l) {
+    qsort(l->us, l->len, sizeof(double), cmp_double);
+    r->p50_us = percentile(l, 50);
+    r->p90_us = percentile(l, 90);
+    r->p99_us = percentile(l, 99);
+    r->max_us = l->len ? l->us[l->len - 1] : 0;
+    free(l->us);
+    memset(l, 0, sizeof(*l));
+}
+
+static void stage_init(StageResult *r, const char *name, const char *unit) {
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    snprintf(r->unit, sizeof(r->unit), "%s", unit);
+}
+
+static size_t file_size(const char *path) {
+    struct stat sb;
+    return stat(path, &sb) == 0 ? (size_t)sb.st_size : 0;
+}
+
+/* ---- Stages ---- each fills results[] and returns how many it filled, 0 on failure. */
+
+typedef struct {
+    size_t entries;
+    CleanWriter *writer;
+} CountingSink;
+
+static int count_and_write(void *ctx, const CleanEntry *e) {
+    CountingSink *s = (CountingSink *)ctx;
+    s->entries++;
+    return clean_writer_add(s->writer, e);
+}
+
+/* read_and_clean_stream (cleaner_read) and the ex1 record loop
+ * (cleaner_parse into the clean file writer), timed per call. */
+static int stage_clean(const char *dir, int reps, StageResult *results) {
+    char in_path[4096], out_path[4096];
+    snprintf(in_path, sizeof(in_path), "%s/dump.txt", dir);
+    snprintf(out_path, sizeof(out_path), "%s/bench_clean_out.txt", dir);
+    StageResult *rd = &results[0], *rec = &results[1];
+    stage_init(rd, "read_and_clean_stream", "bytes");
+    stage_init(rec, "ex1_record_loop", "entries");
+    Latencies lrd = { 0 }, lrec = { 0 };
+    size_t in_bytes = file_size(in_path);
+
+    for (int r = 0; r < reps; r++) {
+        Cleaner *c = cleaner_open(in_path, 1);
+        if (!c) return 0;
+        CountingSink sink = { 0, clean_writer_open(out_path) };
+        if (!sink.writer) {
+            cleaner_close(c);
+            return 0;
+        }
+        int more = 1, parsing = 1;
+        while (more && parsing) {
+            double t0 = now_us();
+            more = cleaner_read(c);
+            double t1 = now_us();
+            if (more < 0) break;
+            parsing = cleaner_parse(c, !more, count_and_write, &sink);
+            double t2 = now_us();
+            if (parsing < 0) break;
+            lat_add(&lrd, t1 - t0);
+            lat_add(&lrec, t2 - t1);
+            rd->seconds += (t1 - t0) / 1e6;
+            rec->seconds += (t2 - t1) / 1e6;
+            rd->calls++;
+            rec->calls++;
+        }
+        int ok = more >= 0 && parsing >= 0;
+        clean_writer_close(sink.writer, ok);
+        cleaner_close(c);
+        if (!ok) return 0;
+        rd->items += in_bytes;
+        rd->bytes += in_bytes;
+        rec->items += sink.entries;
+    }
+    rec->hits = rec->items / (size_t)reps;      /* unique entries per run */
+    remove(out_path);
+    stage_finish(rd, &lrd);
+    stage_finish(rec, &lrec);
+    return 2;
+}
+
+static size_t org_members(const Org *org) {
+    size_t n = 0;
+    if (!org->boss) return 0;
+    n++;
+    const Node *hands[2] = { org->left_hand, org->right_hand };
+    for (int h = 0; h < 2; h++) {
+        if (!hands[h]) continue;
+        n++;
+        for (const Node *s = hands[h]->supports_head; s; s = s->next) n++;
+    }
+    return n;
+}
+
+static int stage_build_org(const char *dir, int reps, StageResult *results) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/clean.txt", dir);
+    StageResult *r = &results[0];
+    stage_init(r, "build_org_from_clean_file", "members");
+    Latencies l = { 0 };
+    size_t bytes = file_size(path);
+    for (int i = 0; i < reps; i++) {
+        double t0 = now_us();
+        Org org = build_org_from_clean_file(path);
+        double t = now_us() - t0;
+        if (!org.boss) {
+            free_org(&org);
+            return 0;
+        }
+        r->items += org_members(&org);
+        r->bytes += bytes;
+        r->seconds += t / 1e6;
+        r->calls++;
+        lat_add(&l, t);
+        free_org(&org);
+    }
+    stage_finish(r, &l);
+    return 1;
+}
+
+/* The dump cleaned into memory and the org built from those entries, the
+ * path pipeline takes instead of ex1's clean file and ex2's re-parse. */
+static int stage_fused_org(const char *dir, int reps, StageResult *results) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/dump.txt", dir);
+    StageResult *r = &results[0];
+    stage_init(r, "clean_to_org_in_memory", "members");
+    Latencies l = { 0 };
+    size_t bytes = file_size(path);
+    for (int i = 0; i < reps; i++) {
+        double t0 = now_us();
+        CleanList list;
+        if (!clean_file_entries(path, 1, &list)) return 0;
+        Org org = build_org_from_list(&list);
+        clean_list_free(&list);
+        double t = now_us() - t0;
+        if (!org.boss) {
+            free_org(&org);
+            return 0;
+        }
+        r->items += org_members(&org);
+        r->bytes += bytes;
+        r->seconds += t / 1e6;
+        r->calls++;
+        lat_add(&l, t);
+        free_org(&org);
+    }
+    stage_finish(r, &l);
+    return 1;
+}
+
+/* The clean file as an N-ary hierarchy, then both traversals over it. */
+static int stage_org_hier(const char *dir, int reps, StageResult *results) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/clean.txt", dir);
+    StageResult *build = &results[0], *walk = &results[1];
+    stage_init(build, "org_hier_from_clean_file", "members");
+    stage_init(walk, "org_hier_traversal", "members");
+    Latencies lb = { 0 }, lw = { 0 };
+    size_t bytes = file_size(path);
+    for (int i = 0; i < reps; i++) {
+        OrgHier h;
+        double t0 = now_us();
+        if (!org_hier_from_clean_file(path, &h)) return 0;
+        double t = now_us() - t0;
+        build->items += h.count;
+        build->bytes += bytes;
+        build->seconds += t / 1e6;
+        build->calls++;
+        lat_add(&lb, t);
+
+        uint32_t *order = (uint32_t *)malloc((h.count ? h.count : 1) * sizeof(uint32_t));
+        if (!order) {
+            org_hier_free(&h);
+            return 0;
+        }
+        t0 = now_us();
+        size_t n = org_hier_preorder(&h, order);
+        n += org_hier_level_order(&h, order);
+        t = now_us() - t0;
+        walk->items += n;
+        walk->seconds += t / 1e6;
+        walk->calls++;
+        lat_add(&lw, t);
+        free(order);
+        org_hier_free(&h);
+    }
+    stage_finish(build, &lb);
+    stage_finish(walk, &lw);
+    return 2;
+}
+
+/* find_match_in_org per cipher, start mask 0, over the indexed org. */
+static int stage_mask_search(const char *dir, int reps, StageResult *results) {
+    char org_path[4096], cipher_path[4096];
+    snprintf(org_path, sizeof(org_path), "%s/clean.txt", dir);
+    snprintf(cipher_path, sizeof(cipher_path), "%s/ciphers.hex", dir);
+    StageResult *r = &results[0];
+    stage_init(r, "ex2_mask_search", "ciphers");
+
+    Org tree = build_org_from_clean_file(org_path);
+    OrgFlat org;
+    OrgIndex ix;
+    memset(&org, 0, sizeof(org));
+    memset(&ix, 0, sizeof(ix));
+    int ok = tree.boss && org_flat_from_org(&tree, &org) && org_index_build_flat(&org, &ix);
+    free_org(&tree);
+
+    CipherReader cr;
+    uint8_t (*ciphers)[CIPHER_LEN] = NULL;
+    size_t n = 0;
+    if (ok && cipher_reader_open(&cr, cipher_path, CIPHER_FMT_HEX)) {
+        size_t cap = 0, got;
+        do {
+            if (n == cap) {
+                cap = cap ? cap * 2 : 4096;
+                uint8_t (*tmp)[CIPHER_LEN] = (uint8_t (*)[CIPHER_LEN])realloc(ciphers, cap * CIPHER_LEN);
+                if (!tmp) break;
+                ciphers = tmp;
+            }
+            got = cipher_reader_next(&cr, ciphers + n, cap - n);
+            n += got;
+        } while (got > 0 && !cr.error);
+        cipher_reader_close(&cr);
+    } else {
+        ok = 0;
+    }
+
+    Latencies l = { 0 };
+    mask_match_init();
+    for (int i = 0; ok && i < reps; i++) {
+        for (size_t k = 0; k < n; k++) {
+            double t0 = now_us();
+            Solution sol = find_match_in_org(&org, &ix, ciphers[k], 0);
+            double t = now_us() - t0;
+            if (sol.node >= 0) r->hits++;
+            r->seconds += t / 1e6;
+            lat_add(&l, t);
+        }
+        r->calls += n;
+        r->items += n;
+        r->bytes += n * CIPHER_LEN;
+    }
+    if (reps > 0) r->hits /= (size_t)reps;      /* ciphers matched per pass */
+    free(ciphers);
+    org_index_free(&ix);
+    org_flat_free(&org);
+    stage_finish(r, &l);
+    return ok;
+}
+
+/* eval_poly_fixed_batch over one random sample per record, FIXED_BLOCK samples per call. */
+static int stage_fixed_point(size_t samples, int reps, StageResult *results) {
+    StageResult *r = &results[0];
+    stage_init(r, "fixed_point_eval", "samples");
+    int16_t *x = (int16_t *)malloc(samples * sizeof(int16_t));
+    int16_t *y = (int16_t *)malloc(samples * sizeof(int16_t));
+    if (!x || !y) {
+        free(x);
+        free(y);
+        return 0;
+    }
+    srand(12345);
+    for (size_t i = 0; i < samples; i++) x[i] = (int16_t)(rand() & 0xFFFF);
+
+    Latencies l = { 0 };
+    eval_poly_fixed_init();
+    for (int i = 0; i < reps; i++) {
+        for (size_t k = 0; k < samples; k += FIXED_BLOCK) {
+            size_t n = samples - k < FIXED_BLOCK ? samples - k : FIXED_BLOCK;
+            double t0 = now_us();
+            eval_poly_fixed_batch(x + k, y + k, n, 301, -1207, 4099, 8);
+            double t = now_us() - t0;
+            r->seconds += t / 1e6;
+            r->calls++;
+            lat_add(&l, t);
+        }
+        r->items += samples;
+        r->bytes += samples * sizeof(int16_t);
+    }
+    free(x);
+    free(y);
+    stage_finish(r, &l);
+    return 1;
+}
+
+/* ---- Runner ---- */
+
+typedef enum { GROUP_CLEAN, GROUP_BUILD_ORG, GROUP_FUSED_ORG, GROUP_ORG_HIER, GROUP_MASK_SEARCH, GROUP_FIXED_POINT, GROUP_COUNT } Group;
+
+typedef struct {
+    StageResult stages[2];
+    int count;
+    long peak_rss_kb;
+} GroupResult;
+
+static int run_group(Group g, const char *dir, int reps, size_t records, StageResult *stages) {
+    switch (g) {
+    case GROUP_CLEAN: return stage_clean(dir, reps, stages);
+    case GROUP_BUILD_ORG: return stage_build_org(dir, reps, stages);
+    case GROUP_FUSED_ORG: return stage_fused_org(dir, reps, stages);
+    case GROUP_ORG_HIER: return stage_org_hier(dir, reps, stages);
+    case GROUP_MASK_SEARCH: return stage_mask_search(dir, reps, stages);
+    case GROUP_FIXED_POINT: return stage_fixed_point(records, reps, stages);
+    default: return 0;
+    }
+}
+
+/* Runs group g in a child and collects its results and peak RSS. */
+static int run_isolated(Group g, const char *dir, int reps, size_t records, GroupResult *out) {
+    int fds[2];
+    memset(out, 0, sizeof(*out));
+    if (pipe(fds) != 0) return 0;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        GroupResult res;
+        memset(&res, 0, sizeof(res));
+        /* progress and error messages from the libraries stay off the JSON */
+        dup2(2, 1);
+        res.count = run_group(g, dir, reps, records, res.stages);
+        ssize_t w = write(fds[1], &res, sizeof(res));
+        _exit(w == (ssize_t)sizeof(res) ? 0 : 1);
+    }
+    close(fds[1]);
+    size_t got = 0;
+    ssize_t n;
+    while (got < sizeof(*out) && (n = read(fds[0], (char *)out + got, sizeof(*out) - got)) > 0) {
+        got += (size_t)n;
+    }
+    close(fds[0]);
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) != pid || got != sizeof(*out)) return 0;
+    out->peak_rss_kb = ru.ru_maxrss;
+    return out->count > 0;
+}
+
+static void print_stage(const StageResult *r, long peak_rss_kb, int last) {
+    double per_s = r->seconds > 0 ? (double)r->items / r->seconds : 0;
+    double mb_s = r->seconds > 0 ? (double)r->bytes / r->seconds / 1e6 : 0;
+    printf("    {\"name\": \"%s\", \"calls\": %zu, \"items\": %zu, \"unit\": \"%s\", \"bytes\": %zu,"
+           " \"hits\": %zu, \"seconds\": %.6f, \"items_per_s\": %.1f, \"mb_per_s\": %.2f,\n"
+           "     \"latency_us\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f},"
+           " \"peak_rss_kb\": %ld}%s\n",
+           r->name, r->calls, r->items, r->unit, r->bytes, r->hits, r->seconds, per_s, mb_s,
+           r->p50_us, r->p90_us, r->p99_us, r->max_us, peak_rss_kb, last ? "" : ",");
+}
+
+/* s inside a JSON string. */
+static void print_json_chars(const char *s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') putchar('\\');
+        if ((unsigned char)*s >= 0x20) putchar(*s);
+    }
+}
+
+/* Counts the records of the clean org file, which gen writes one per member. */
+static size_t count_records(const char *dir) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/clean.txt", dir);
+    Org org = build_org_from_clean_file(path);
+    size_t n = org_members(&org);
+    free_org(&org);
+    return n;
+}
+
+int main(int argc, char **argv) {
+    const char *label = "";
+    if (argc > 2 && strcmp(argv[1], "--label") == 0) {
+        label = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc < 2 || argc > 3) {
+        printf("Usage: %s [--label text] <data_dir> [reps]\n", argv[0]);
+        printf("data_dir holds dump.txt, clean.txt and ciphers.hex from bench/gen\n");
+        return 0;
+    }
+    const char *dir = argv[1];
+    int reps = argc > 2 ? atoi(argv[2]) : 3;
+    if (reps < 1) reps = 1;
+
+    size_t records = count_records(dir);
+    if (records == 0) {
+        fprintf(stderr, "No benchmark data in %s (run bench/gen first)\n", dir);
+        return 1;
+    }
+
+    GroupResult groups[GROUP_COUNT];
+    int failed = 0;
+    for (int g = 0; g < GROUP_COUNT; g++) {
+        if (!run_isolated((Group)g, dir, reps, records, &groups[g])) {
+            fprintf(stderr, "Benchmark stage group %d failed\n", g);
+            groups[g].count = 0;
+            failed = 1;
+        }
+    }
+
+    char dump[4096];
+    snprintf(dump, sizeof(dump), "%s/dump.txt", dir);
+    eval_poly_fixed_init();
+    mask_match_init();
+    printf("{\n  \"label\": \"");
+    print_json_chars(label);
+    printf("\",\n  \"records\": %zu,\n  \"dump_bytes\": %zu,\n  \"reps\": %d,\n",
+           records, file_size(dump), reps);
+    printf("  \"kernels\": {\"fixed_point\": \"%s\", \"mask_match\": \"%s\"},\n",
+           eval_poly_fixed_kernel_name(), mask_match_kernel_name());
+    printf("  \"stages\": [\n");
+    int total = 0, printed = 0;
+    for (int g = 0; g < GROUP_COUNT; g++) total += groups[g].count;
+    for (int g = 0; g < GROUP_COUNT; g++) {
+        for (int i = 0; i < groups[g].count; i++) {
+            printed++;
+            print_stage(&groups[g].stages[i], groups[g].peak_rss_kb, printed == total);
+        }
+    }
+    printf("  ]\n}\n");
+    return failed;
+}
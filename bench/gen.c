@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "tests/test_rng.h"
+
+/* Synthetic inputs for the benchmark, all derived from one seed:
+ *   dump.txt     corrupted dump of <records> records for ex1: corruption
+ *                characters and whitespace sprinkled through every field,
+ *                about one record in five repeating an earlier fingerprint,
+ *                mixed position spellings and a few unknown positions
+ *   clean.txt    clean org file of <records> members for ex2 (Boss, both
+ *                Hands, then supports alternating between the Hands)
+ *   ciphers.hex  <ciphers> ciphers, one per line: a member's fingerprint
+ *                under XOR or AND with a mask in 0..10 (start mask 0), and
+ *                about one in ten random, which finds no member
+ * Sizes from 1K to 10M records are the intended range. */
+
+#define FP_CHARS 9
+#define CIPHER_LEN 9
+#define DEFAULT_CIPHERS 10000
+
+/* Fingerprint number i: fixed by (seed, i), so repeats need no table. */
+static void fingerprint(char out[FP_CHARS + 1], uint64_t seed, uint64_t i) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    uint64_t h = (seed + 1) * 0x9E3779B97F4A7C15ULL ^ (i + 1) * 0xC2B2AE3D27D4EB4FULL;
+    for (int k = 0; k < FP_CHARS; k++) {
+        h ^= h >> 31;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 29;
+        out[k] = alphabet[(h >> 32) % 36];
+    }
+    out[FP_CHARS] = '\0';
+}
+
+typedef struct {
+    FILE *f;
+    char buf[1 << 16];
+    size_t len;
+} Out;
+
+static void out_flush(Out *o) {
+    fwrite(o->buf, 1, o->len, o->f);
+    o->len = 0;
+}
+
+static void out_char(Out *o, char c) {
+    if (o->len == sizeof(o->buf)) out_flush(o);
+    o->buf[o->len++] = c;
+}
+
+static void out_str(Out *o, const char *s) {
+    while (*s) out_char(o, *s++);
+}
+
+/* s with a corruption character or whitespace before about 15% of bytes. */
+static void out_noisy(Out *o, const char *s) {
+    static const char noise[] = "#?!@&$ \t\r\n";
+    for (; *s; s++) {
+        if (rng_below(100) < 15) out_char(o, noise[rng_below(sizeof(noise) - 1)]);
+        out_char(o, *s);
+    }
+}
+
+static int out_open(Out *o, const char *dir, const char *name) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    o->f = fopen(path, "wb");
+    o->len = 0;
+    if (!o->f) printf("Error opening file: %s\n", path);
+    return o->f != NULL;
+}
+
+static int out_close(Out *o) {
+    out_flush(o);
+    return fclose(o->f) == 0;
+}
+
+static const char *const dump_positions[] = {
+    "Support_Right", "Support Right", "SupportRight",
+    "Support_Left", "Support Left", "SupportLeft",
+};
+
+static int write_dump(const char *dir, uint64_t seed, uint64_t records) {
+    Out o;
+    if (!out_open(&o, dir, "dump.txt")) return 0;
+    char fp[FP_CHARS + 1], line[256];
+    for (uint64_t i = 0; i < records; i++) {
+        uint64_t id = i;
+        if (i > 3 && rng_below(5) == 0) id = rng_next() % i;    /* repeat */
+        fingerprint(fp, seed, id);
+
+        const char *pos;
+        if (i == 0) pos = "Boss";
+        else if (i == 1) pos = "Right_Hand";
+        else if (i == 2) pos = "Left Hand";
+        else if (rng_below(50) == 0) pos = "Janitor";
+        else pos = dump_positions[rng_below(6)];
+
+        snprintf(line, sizeof(line), "First Name: Name%u\nSecond Name: Surname%llu\n",
+                 rng_below(1000000), (unsigned long long)i);
+        out_noisy(&o, line);
+        snprintf(line, sizeof(line), "Fingerprint: %s\nPosition: %s\n\n", fp, pos);
+        out_noisy(&o, line);
+    }
+    return out_close(&o);
+}
+
+static const char *clean_position(uint64_t i) {
+    if (i == 0) return "Boss";
+    if (i == 1) return "Right Hand";
+    if (i == 2) return "Left Hand";
+    return (i & 1) ? "Support_Right" : "Support_Left";
+}
+
+static int write_clean(const char *dir, uint64_t seed, uint64_t records) {
+    Out o;
+    if (!out_open(&o, dir, "clean.txt")) return 0;
+    char fp[FP_CHARS + 1], rec[512];
+    for (uint64_t i = 0; i < records; i++) {
+        fingerprint(fp, seed, i);
+        snprintf(rec, sizeof(rec),
+                 "First Name: Name%llu\nSecond Name: Surname%llu\nFingerprint: %s\nPosition: %s\n\n",
+                 (unsigned long long)i, (unsigned long long)i, fp, clean_position(i));
+        out_str(&o, rec);
+    }
+    return out_close(&o);
+}
+
+static int write_ciphers(const char *dir, uint64_t seed, uint64_t records, uint64_t count) {
+    static const char hex[] = "0123456789abcdef";
+    Out o;
+    if (!out_open(&o, dir, "ciphers.hex")) return 0;
+    char fp[FP_CHARS + 1];
+    for (uint64_t n = 0; n < count; n++) {
+        uint8_t c[CIPHER_LEN];
+        if (rng_below(10) == 0) {
+            for (int k = 0; k < CIPHER_LEN; k++) c[k] = (uint8_t)rng_next();
+        } else {
+            fingerprint(fp, seed, rng_next() % records);
+            uint8_t mask = (uint8_t)rng_below(11);
+            int use_and = rng_below(2);
+            for (int k = 0; k < CIPHER_LEN; k++) {
+                c[k] = use_and ? (uint8_t)((uint8_t)fp[k] & mask) : (uint8_t)((uint8_t)fp[k] ^ mask);
+            }
+        }
+        for (int k = 0; k < CIPHER_LEN; k++) {
+            out_char(&o, hex[c[k] >> 4]);
+            out_char(&o, hex[c[k] & 15]);
+        }
+        out_char(&o, '\n');
+    }
+    return out_close(&o);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || argc > 5) {
+        printf("Usage: %s <out_dir> <records> [seed] [ciphers]\n", argv[0]);
+        return 0;
+    }
+    const char *dir = argv[1];
+    uint64_t records = strtoull(argv[2], NULL, 10);
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    uint64_t ciphers = argc > 4 ? strtoull(argv[4], NULL, 10) : DEFAULT_CIPHERS;
+    if (records < 3) {
+        printf("records must be at least 3 (Boss and both Hands)\n");
+        return 0;
+    }
+    mkdir(dir, 0777);
+
+    rng_seed(seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL);
+    if (!write_dump(dir, seed, records) || !write_clean(dir, seed, records) ||
+        !write_ciphers(dir, seed, records, ciphers)) {
+        printf("Error writing benchmark data in %s\n", dir);
+        return 1;
+    }
+    return 0;
+}
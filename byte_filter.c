@@ -0,0 +1,174 @@
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "byte_filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTE_FILTER_X86 1
+#endif
+
+typedef size_t (*FilterKernel)(char *dst, const char *src, size_t n);
+
+static FilterKernel kernel = NULL;
+static const char *kernel_name = "scalar";
+
+static int is_corruption_char(char c) {
+    return (c == '#' || c == '?' || c == '!' || c == '@' || c == '&' || c == '$');
+}
+
+size_t byte_filter_scalar(char *dst, const char *src, size_t n) {
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        char c = src[i];
+        if (is_corruption_char(c)) continue;
+        if (isspace((unsigned char)c)) continue;
+        dst[len++] = c;
+    }
+    return len;
+}
+
+#ifdef BYTE_FILTER_X86
+
+/* For each 8-bit keep mask, the pshufb indices that pack the kept bytes of an
+ * 8-byte group to the front. */
+static uint64_t compact_table[256];
+
+static void build_compact_table(void) {
+    for (int m = 0; m < 256; m++) {
+        uint64_t idx = 0;
+        int k = 0;
+        for (int b = 0; b < 8; b++) {
+            if (m & (1 << b)) idx |= (uint64_t)b << (8 * k++);
+        }
+        compact_table[m] = idx;
+    }
+}
+
+/* Drop mask for 16 bytes: the six corruption characters, ' ' and \t..\r. */
+__attribute__((target("sse2")))
+static __m128i classify_sse2(__m128i v) {
+    __m128i drop = _mm_cmpeq_epi8(v, _mm_set1_epi8('#'));
+    drop = _mm_or_si128(drop, _mm_cmpeq_epi8(v, _mm_set1_epi8('?')));
+    drop = _mm_or_si128(drop, _mm_cmpeq_epi8(v, _mm_set1_epi8('!')));
+    drop = _mm_or_si128(drop, _mm_cmpeq_epi8(v, _mm_set1_epi8('@')));
+    drop = _mm_or_si128(drop, _mm_cmpeq_epi8(v, _mm_set1_epi8('&')));
+    drop = _mm_or_si128(drop, _mm_cmpeq_epi8(v, _mm_set1_epi8('$')));
+    drop = _mm_or_si128(drop, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    /* unsigned (v - '\t') <= 4 */
+    __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    drop = _mm_or_si128(drop, _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t));
+    return drop;
+}
+
+__attribute__((target("sse2")))
+static size_t byte_filter_sse2(char *dst, const char *src, size_t n) {
+    size_t len = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        unsigned keep = ~(unsigned)_mm_movemask_epi8(classify_sse2(v)) & 0xFFFFu;
+        if (keep == 0xFFFFu) {
+            _mm_storeu_si128((__m128i *)(dst + len), v);
+            len += 16;
+            continue;
+        }
+        while (keep) {
+            dst[len++] = src[i + (size_t)__builtin_ctz(keep)];
+            keep &= keep - 1;
+        }
+    }
+    return len + byte_filter_scalar(dst + len, src + i, n - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t byte_filter_avx2(char *dst, const char *src, size_t n) {
+    size_t len = 0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i drop = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('#'));
+        drop = _mm256_or_si256(drop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('?')));
+        drop = _mm256_or_si256(drop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('!')));
+        drop = _mm256_or_si256(drop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('@')));
+        drop = _mm256_or_si256(drop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')));
+        drop = _mm256_or_si256(drop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('$')));
+        drop = _mm256_or_si256(drop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+        __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+        drop = _mm256_or_si256(drop, _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(4)), t));
+
+        uint32_t keep = ~(uint32_t)_mm256_movemask_epi8(drop);
+        if (keep == 0xFFFFFFFFu) {
+            _mm256_storeu_si256((__m256i *)(dst + len), v);
+            len += 32;
+            continue;
+        }
+        if (keep == 0) continue;
+
+        /* pack each 8-byte group with one shuffle */
+        for (int g = 0; g < 4; g++) {
+            unsigned m = (keep >> (8 * g)) & 0xFFu;
+            __m128i bytes = _mm_loadl_epi64((const __m128i *)(src + i + 8 * g));
+            __m128i idx = _mm_loadl_epi64((const __m128i *)&compact_table[m]);
+            _mm_storel_epi64((__m128i *)(dst + len), _mm_shuffle_epi8(bytes, idx));
+            len += (size_t)__builtin_popcount(m);
+        }
+    }
+    return len + byte_filter_scalar(dst + len, src + i, n - i);
+}
+
+#endif
+
+void byte_filter_init(void) {
+    if (kernel) return;
+#ifdef BYTE_FILTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        build_compact_table();
+        kernel_name = "avx2";
+        kernel = byte_filter_avx2;
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        kernel_name = "sse2";
+        kernel = byte_filter_sse2;
+        return;
+    }
+#endif
+    kernel_name = "scalar";
+    kernel = byte_filter_scalar;
+}
+
+size_t byte_filter(char *dst, const char *src, size_t n) {
+    if (!kernel) byte_filter_init();
+    return kernel(dst, src, n);
+}
+
+const char *byte_filter_kernel_name(void) {
+    byte_filter_init();
+    return kernel_name;
+}
+
+int byte_filter_use(const char *name) {
+    byte_filter_init();
+    if (strcmp(name, "scalar") == 0) {
+        kernel_name = "scalar";
+        kernel = byte_filter_scalar;
+        return 1;
+    }
+#ifdef BYTE_FILTER_X86
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        kernel_name = "sse2";
+        kernel = byte_filter_sse2;
+        return 1;
+    }
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        build_compact_table();
+        kernel_name = "avx2";
+        kernel = byte_filter_avx2;
+        return 1;
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef BYTE_FILTER_H
+#define BYTE_FILTER_H
+
+#include <stddef.h>
+
+/* Extra bytes the vector kernels may write past the last kept byte. */
+#define BYTE_FILTER_SLACK 32
+
+/* Picks the fastest kernel for this CPU. Called implicitly by byte_filter(),
+ * call it up front when several threads will filter concurrently. */
+void byte_filter_init(void);
+
+/* Copies the bytes of src[0..n) that are neither corruption characters
+ * (# ? ! @ & $) nor whitespace into dst and returns how many were kept.
+ * dst must have room for n + BYTE_FILTER_SLACK bytes; dst == src filters in
+ * place (the kept bytes never overtake the bytes still to be read). */
+size_t byte_filter(char *dst, const char *src, size_t n);
+
+/* Reference one-byte-at-a-time implementation. */
+size_t byte_filter_scalar(char *dst, const char *src, size_t n);
+
+/* Name of the kernel byte_filter() dispatches to ("avx2", "sse2", "scalar"). */
+const char *byte_filter_kernel_name(void);
+
+/* Makes byte_filter() dispatch to the named kernel instead of the one picked
+ * for this CPU, e.g. to compare them. Returns 0 and changes nothing if this
+ * CPU or build cannot run it. */
+int byte_filter_use(const char *name);
+
+#endif // BYTE_FILTER_H
@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "cipher_reader.h"
+
+/* hex digit value, 0x80 for anything else */
+static uint8_t hex_value[256];
+static int hex_ready = 0;
+
+void cipher_reader_init(void) {
+    if (hex_ready) return;
+    memset(hex_value, 0x80, sizeof(hex_value));
+    for (int i = 0; i < 10; i++) hex_value['0' + i] = (uint8_t)i;
+    for (int i = 0; i < 6; i++) {
+        hex_value['a' + i] = (uint8_t)(10 + i);
+        hex_value['A' + i] = (uint8_t)(10 + i);
+    }
+    hex_ready = 1;
+}
+
+/* Eight '0'/'1' characters to one byte, first character the top bit.
+ * Returns 0 if any of them is something else. */
+static int pack_bits(const char *p, uint8_t *out) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    w -= 0x3030303030303030ULL;
+    /* anything but 0 / 1 in a byte (including a borrow from one) shows up here */
+    if (w & 0xFEFEFEFEFEFEFEFEULL) return 0;
+    /* gather the low bit of every byte into the top byte, byte 0 first */
+    *out = (uint8_t)((w * 0x8040201008040201ULL) >> 56);
+    return 1;
+}
+
+/* 18 hex digits to CIPHER_LEN bytes. Returns 0 on a non-hex character. */
+static int pack_hex(const char *p, uint8_t out[CIPHER_LEN]) {
+    uint8_t bad = 0;
+    for (int i = 0; i < CIPHER_LEN; i++) {
+        uint8_t hi = hex_value[(uint8_t)p[2 * i]];
+        uint8_t lo = hex_value[(uint8_t)p[2 * i + 1]];
+        bad |= hi | lo;
+        out[i] = (uint8_t)((hi << 4) | (lo & 0x0F));
+    }
+    return !(bad & 0x80);
+}
+
+/* Next line of the span from *pos, without its terminator. */
+static int next_line(const CipherReader *r, size_t *pos, const char **line, size_t *len) {
+    const char *data = r->span.data;
+    size_t n = r->span.len;
+    if (*pos >= n) return 0;
+    const char *nl = (const char *)memchr(data + *pos, '\n', n - *pos);
+    size_t end = nl ? (size_t)(nl - data) : n;
+    *line = data + *pos;
+    *len = end - *pos;
+    *pos = nl ? end + 1 : n;
+    return 1;
+}
+
+static void trim(const char **line, size_t *len) {
+    while (*len && (**line == ' ' || **line == '\t')) {
+        (*line)++;
+        (*len)--;
+    }
+    while (*len && ((*line)[*len - 1] == '\r' || (*line)[*len - 1] == ' ' || (*line)[*len - 1] == '\t')) (*len)--;
+}
+
+static int is_hex_line(const char *line, size_t len) {
+    uint8_t tmp[CIPHER_LEN];
+    return len == 2 * CIPHER_LEN && pack_hex(line, tmp);
+}
+
+/* Picks the format from the first line holding data: 18 hex digits is
+ * hex unless they are all '0'/'1', which the original bits reader took as
+ * one byte and still does. Anything else is taken as bits, whose reader
+ * uses a line's first eight characters. */
+static CipherFormat detect_format(const CipherReader *r) {
+    if (r->span.len >= CIPHER_BIN_MAGIC_LEN && memcmp(r->span.data, CIPHER_BIN_MAGIC, CIPHER_BIN_MAGIC_LEN) == 0) {
+        return CIPHER_FMT_BINARY;
+    }
+    size_t pos = 0;
+    const char *line;
+    size_t len;
+    while (next_line(r, &pos, &line, &len)) {
+        trim(&line, &len);
+        if (len == 0 || line[0] == '#') continue;
+        size_t binary = 0;
+        while (binary < len && (line[binary] == '0' || line[binary] == '1')) binary++;
+        return binary < len && is_hex_line(line, len) ? CIPHER_FMT_HEX : CIPHER_FMT_BITS;
+    }
+    return CIPHER_FMT_BITS;
+}
+
+int cipher_reader_open(CipherReader *r, const char *path, CipherFormat fmt) {
+    memset(r, 0, sizeof(*r));
+    cipher_reader_init();
+    if (!span_open(&r->span, strcmp(path, "-") == 0 ? "/dev/stdin" : path)) return 0;
+    r->fmt = fmt == CIPHER_FMT_AUTO ? detect_format(r) : fmt;
+    if (r->fmt == CIPHER_FMT_BINARY) {
+        if (r->span.len < CIPHER_BIN_MAGIC_LEN || memcmp(r->span.data, CIPHER_BIN_MAGIC, CIPHER_BIN_MAGIC_LEN) != 0) {
+            r->error = 1;
+        }
+        r->pos = CIPHER_BIN_MAGIC_LEN;
+    }
+    return 1;
+}
+
+/* The original reader took lines through a 128-byte fgets buffer, so a
+ * longer line reads as pieces of BITS_PIECE characters, each one a line of
+ * its own. Next such piece from *pos, without its newline. */
+#define BITS_PIECE 127
+
+static int next_piece(const CipherReader *r, size_t *pos, const char **line, size_t *len) {
+    const char *data = r->span.data;
+    size_t n = r->span.len;
+    if (*pos >= n) return 0;
+    size_t room = n - *pos < BITS_PIECE ? n - *pos : BITS_PIECE;
+    const char *nl = (const char *)memchr(data + *pos, '\n', room);
+    *line = data + *pos;
+    *len = nl ? (size_t)(nl - *line) : room;
+    *pos += nl ? *len + 1 : room;
+    return 1;
+}
+
+static size_t next_bits(CipherReader *r, uint8_t (*out)[CIPHER_LEN], size_t max) {
+    size_t got = 0;
+    int have = 0;           /* bytes of the current cipher */
+    size_t start = r->pos;  /* where the current cipher began */
+    const char *line;
+    size_t len;
+    while (got < max && next_piece(r, &r->pos, &line, &len)) {
+        if (len < 8) continue;
+        if (!pack_bits(line, &out[got][have])) {
+            /* the original reader ends a line at '\r' or NUL as well, so
+             * such a line is just short */
+            if (memchr(line, '\r', 8) || memchr(line, '\0', 8)) continue;
+            r->error = 1;
+            return got;
+        }
+        if (++have == CIPHER_LEN) {
+            got++;
+            have = 0;
+            start = r->pos;
+        }
+    }
+    if (have) {
+        if (got < max) {
+            /* input ended inside a cipher */
+            r->error = 1;
+        } else {
+            r->pos = start;
+        }
+    }
+    return got;
+}
+
+static size_t next_hex(CipherReader *r, uint8_t (*out)[CIPHER_LEN], size_t max) {
+    size_t got = 0;
+    const char *line;
+    size_t len;
+    while (got < max && next_line(r, &r->pos, &line, &len)) {
+        trim(&line, &len);
+        if (len == 0 || line[0] == '#') continue;
+        if (len != 2 * CIPHER_LEN || !pack_hex(line, out[got])) {
+            r->error = 1;
+            return got;
+        }
+        got++;
+    }
+    return got;
+}
+
+static size_t next_binary(CipherReader *r, uint8_t (*out)[CIPHER_LEN], size_t max) {
+    size_t left = r->span.len - r->pos;
+    size_t n = left / CIPHER_LEN;
+    if (n > max) n = max;
+    memcpy(out, r->span.data + r->pos, n * CIPHER_LEN);
+    r->pos += n * CIPHER_LEN;
+    if (n < max && left % CIPHER_LEN) r->error = 1;   /* truncated record */
+    return n;
+}
+
+size_t cipher_reader_next(CipherReader *r, uint8_t (*out)[CIPHER_LEN], size_t max) {
+    if (r->error || max == 0) return 0;
+    size_t got;
+    switch (r->fmt) {
+    case CIPHER_FMT_HEX:    got = next_hex(r, out, max); break;
+    case CIPHER_FMT_BINARY: got = next_binary(r, out, max); break;
+    default:                got = next_bits(r, out, max); break;
+    }
+    r->records += got;
+    return got;
+}
+
+void cipher_reader_close(CipherReader *r) {
+    span_close(&r->span);
+    memset(r, 0, sizeof(*r));
+}
+
+static const char *const FORMAT_NAMES[] = { "auto", "bits", "hex", "binary" };
+
+const char *cipher_format_name(CipherFormat fmt) {
+    return FORMAT_NAMES[fmt];
+}
+
+int cipher_format_parse(const char *name, CipherFormat *fmt) {
+    for (int i = 0; i < (int)(sizeof(FORMAT_NAMES) / sizeof(FORMAT_NAMES[0])); i++) {
+        if (strcmp(name, FORMAT_NAMES[i]) == 0) {
+            *fmt = (CipherFormat)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int cipher_write_binary(const char *path, const uint8_t (*ciphers)[CIPHER_LEN], size_t count) {
+    OutBuf ob;
+    if (!outbuf_open(&ob, path)) {
+        printf("Error opening file: %s\n", path);
+        return 0;
+    }
+    outbuf_put(&ob, CIPHER_BIN_MAGIC, CIPHER_BIN_MAGIC_LEN);
+    outbuf_put(&ob, (const char *)ciphers, count * CIPHER_LEN);
+    if (!outbuf_close(&ob)) {
+        printf("Error writing file: %s\n", path);
+        return 0;
+    }
+    return 1;
+}
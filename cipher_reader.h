@@ -0,0 +1,64 @@
+#ifndef CIPHER_READER_H
+#define CIPHER_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "io_buf.h"
+
+/* Bytes in one cipher. */
+#define CIPHER_LEN 9
+
+/* On-disk cipher formats:
+ *   bits    nine lines of eight '0'/'1' (the original format; longer lines
+ *           use their first eight characters, shorter ones are skipped).
+ *           As in the original reader, a line is read 127 characters at a
+ *           time and each piece counts as a line. A file may hold several
+ *           ciphers back to back.
+ *   hex     one cipher per line as 18 hex digits; blank lines and lines
+ *           starting with '#' are skipped.
+ *   binary  CIPHER_BIN_MAGIC followed by packed 9-byte records.
+ * CIPHER_FMT_AUTO picks binary on the magic, else looks at the first line
+ * that is not blank or a comment: 18 hex digits is hex, anything else bits.
+ * 18 '0'/'1' digits fit both and stay bits, as the original reader read
+ * them; a hex file whose first cipher has only 0/1 digits needs
+ * CIPHER_FMT_HEX. */
+typedef enum {
+    CIPHER_FMT_AUTO,
+    CIPHER_FMT_BITS,
+    CIPHER_FMT_HEX,
+    CIPHER_FMT_BINARY
+} CipherFormat;
+
+#define CIPHER_BIN_MAGIC     "CIPHBIN1"
+#define CIPHER_BIN_MAGIC_LEN 8
+
+typedef struct {
+    InputSpan span;
+    size_t pos;
+    CipherFormat fmt;       /* resolved format */
+    size_t records;         /* ciphers returned so far */
+    int error;              /* set when a record is malformed */
+} CipherReader;
+
+/* Builds the parse tables. Called implicitly by cipher_reader_open(), call
+ * it up front when several threads will open readers concurrently. */
+void cipher_reader_init(void);
+
+/* Returns 1 on success, 0 if the file cannot be opened ("-" is stdin). */
+int  cipher_reader_open(CipherReader *r, const char *path, CipherFormat fmt);
+/* Parses up to max ciphers into out. Returns how many; fewer than max only
+ * at the end of input or at a malformed record (r->error is then set and the
+ * record is number r->records, counting from 0). */
+size_t cipher_reader_next(CipherReader *r, uint8_t (*out)[CIPHER_LEN], size_t max);
+void cipher_reader_close(CipherReader *r);
+
+/* "auto", "bits", "hex", "binary". parse returns 0 for an unknown name. */
+const char *cipher_format_name(CipherFormat fmt);
+int cipher_format_parse(const char *name, CipherFormat *fmt);
+
+/* Writes count ciphers as a binary cipher file. Returns 1 on success, 0 on
+ * failure (message printed). */
+int cipher_write_binary(const char *path, const uint8_t (*ciphers)[CIPHER_LEN], size_t count);
+
+#endif // CIPHER_READER_H
@@ -0,0 +1,1134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "cleaner.h"
+#include "byte_filter.h"
+#include "label_scan.h"
+#include "io_buf.h"
+#include "stats.h"
+
+/* Input is consumed in fixed-size chunks; only the cleaned tail that may still
+ * belong to an unfinished record is carried over to the next chunk. */
+#define CHUNK_SIZE 65536
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    LabelHits labels;   /* label occurrences starting before `scanned` */
+    size_t scanned;
+    int ended;          /* input stopped at an embedded NUL */
+} CleanBuf;
+
+/* -j N: each window of N * SLICE_SIZE input bytes is split into N slices that
+ * are filtered and tokenized concurrently. Records are then cut sequentially
+ * from the merged label list, which also stitches together the records that
+ * straddle a slice edge, so the output does not depend on N. */
+#define SLICE_SIZE (4u << 20)
+
+/* More threads than slices of input only cost memory: each one reserves a
+ * slice of filter output up front. */
+#define MAX_THREADS 256
+
+typedef struct {
+    const char *src;
+    size_t n;
+    char *dst;
+    size_t kept;
+} FilterJob;
+
+typedef struct {
+    const char *text;
+    size_t len;
+    size_t from;
+    size_t to;
+    LabelHits hits;
+    int ok;
+} ScanJob;
+
+typedef struct {
+    int count;
+    char *raw;          /* filter output, one SLICE_SIZE region per worker */
+    size_t raw_cap;
+    FilterJob *filter;
+    ScanJob *scan;
+    pthread_t *tids;
+} Workers;
+
+static int workers_init(Workers *w, int count) {
+    memset(w, 0, sizeof(*w));
+    w->count = count;
+    if (count <= 1) return 1;
+    w->raw_cap = (size_t)count * SLICE_SIZE;
+    w->raw = (char *)malloc(w->raw_cap + BYTE_FILTER_SLACK);
+    w->filter = (FilterJob *)calloc((size_t)count, sizeof(FilterJob));
+    w->scan = (ScanJob *)calloc((size_t)count, sizeof(ScanJob));
+    w->tids = (pthread_t *)calloc((size_t)count, sizeof(pthread_t));
+    if (!w->raw || !w->filter || !w->scan || !w->tids) return 0;
+    /* the kernels and the automaton are shared read-only by the workers */
+    byte_filter_init();
+    label_scan_init();
+    return 1;
+}
+
+static void workers_free(Workers *w) {
+    if (w->scan) {
+        for (int i = 0; i < w->count; i++) label_hits_free(&w->scan[i].hits);
+    }
+    free(w->raw);
+    free(w->filter);
+    free(w->scan);
+    free(w->tids);
+}
+
+/* Runs fn on every job, one per worker; the calling thread takes job 0.
+ * Returns 0 if a thread could not be started. */
+static int run_jobs(Workers *w, void *(*fn)(void *), void *jobs, size_t job_size) {
+    int started = 1;
+    for (int i = 1; i < w->count; i++) {
+        if (pthread_create(&w->tids[i], NULL, fn, (char *)jobs + (size_t)i * job_size) != 0) break;
+        started++;
+    }
+    fn(jobs);
+    for (int i = 1; i < started; i++) pthread_join(w->tids[i], NULL);
+    return started == w->count;
+}
+
+static void *filter_worker(void *arg) {
+    FilterJob *job = (FilterJob *)arg;
+    job->kept = byte_filter(job->dst, job->src, job->n);
+    return NULL;
+}
+
+static void *scan_worker(void *arg) {
+    ScanJob *job = (ScanJob *)arg;
+    job->hits.len = 0;
+    job->ok = label_scan(job->text, job->len, job->from, job->to, &job->hits);
+    return NULL;
+}
+
+/* Reads the next chunk (or -j window) of in, filters it and appends it to cb.
+ * Returns 1 if more input may follow, 0 at end of input, -1 on failure. */
+static int read_and_clean_stream(InputReader *in, CleanBuf *cb, Workers *w) {
+    if (cb->ended) return 0;
+    const char *raw;
+    STAT_TIMER_START(STAT_READ);
+    size_t n = reader_next(in, &raw);
+    STAT_TIMER_STOP(STAT_READ);
+    int more = (n == in->chunk);
+
+    /* the whole-buffer parser never looked past an embedded NUL, so stop there too */
+    const char *nul = (const char *)memchr(raw, '\0', n);
+    if (nul) {
+        n = (size_t)(nul - raw);
+        more = 0;
+        cb->ended = 1;
+    }
+
+    size_t need = cb->len + n + 1 + BYTE_FILTER_SLACK;
+    if (need > cb->cap) {
+        size_t cap = cb->cap ? cb->cap : 4096;
+        while (need > cap) cap *= 2;
+        char *tmp = (char *)realloc(cb->buf, cap);
+        if (!tmp) {
+            printf("Memory allocation failed\n");
+            return -1;
+        }
+        cb->buf = tmp;
+        cb->cap = cap;
+    }
+
+    /* drop corruption characters and all whitespace so labels/values can be
+     * reconstructed across lines */
+    STAT_TIMER_START(STAT_FILTER);
+    size_t kept = 0;
+    if (w->count > 1) {
+        size_t per = (n + (size_t)w->count - 1) / (size_t)w->count;
+        for (int i = 0; i < w->count; i++) {
+            size_t from = (size_t)i * per;
+            if (from > n) from = n;
+            w->filter[i].src = raw + from;
+            w->filter[i].n = (from + per < n) ? per : n - from;
+            w->filter[i].dst = w->raw + from;
+        }
+        if (!run_jobs(w, filter_worker, w->filter, sizeof(FilterJob))) {
+            printf("Error starting worker threads\n");
+            return -1;
+        }
+        for (int i = 0; i < w->count; i++) {
+            memcpy(cb->buf + cb->len + kept, w->filter[i].dst, w->filter[i].kept);
+            kept += w->filter[i].kept;
+        }
+    } else {
+        kept = byte_filter(cb->buf + cb->len, raw, n);
+    }
+    cb->len += kept;
+    cb->buf[cb->len] = '\0';
+    STAT_TIMER_STOP(STAT_FILTER);
+    STAT_COUNT(STAT_BYTES_IN, n);
+    STAT_COUNT(STAT_BYTES_DROPPED, n - kept);
+    return more;
+}
+
+/* Appends the labels starting in [from, to) of cb to cb->labels, splitting the
+ * range across the workers when it is large. Returns 0 on failure. */
+static int scan_labels(CleanBuf *cb, size_t from, size_t to, Workers *w) {
+    if (w->count <= 1 || to - from < (1u << 20)) {
+        return label_scan(cb->buf, cb->len, from, to, &cb->labels);
+    }
+
+    size_t per = (to - from + (size_t)w->count - 1) / (size_t)w->count;
+    for (int i = 0; i < w->count; i++) {
+        ScanJob *job = &w->scan[i];
+        job->text = cb->buf;
+        job->len = cb->len;
+        job->from = from + (size_t)i * per;
+        if (job->from > to) job->from = to;
+        job->to = (job->from + per < to) ? job->from + per : to;
+    }
+    if (!run_jobs(w, scan_worker, w->scan, sizeof(ScanJob))) return 0;
+
+    /* hits of consecutive ranges are already in order */
+    for (int i = 0; i < w->count; i++) {
+        const LabelHits *h = &w->scan[i].hits;
+        if (!w->scan[i].ok) return 0;
+        if (cb->labels.len + h->len > cb->labels.cap) {
+            size_t cap = cb->labels.cap ? cb->labels.cap : 64;
+            while (cb->labels.len + h->len > cap) cap *= 2;
+            LabelHit *tmp = (LabelHit *)realloc(cb->labels.hits, cap * sizeof(LabelHit));
+            if (!tmp) return 0;
+            cb->labels.hits = tmp;
+            cb->labels.cap = cap;
+        }
+        memcpy(cb->labels.hits + cb->labels.len, h->hits, h->len * sizeof(LabelHit));
+        cb->labels.len += h->len;
+    }
+    return 1;
+}
+
+static void trim_inplace(char *s) {
+    if (!s) return;
+    size_t n = strlen(s);
+    size_t i = 0;
+    while (i < n && isspace((unsigned char)s[i])) i++;
+    if (i > 0) memmove(s, s + i, n - i + 1);
+    n = strlen(s);
+    while (n > 0 && isspace((unsigned char)s[n - 1])) {
+        s[n - 1] = '\0';
+        n--;
+    }
+}
+
+static void copy_trimmed_range(char *dst, size_t dst_cap, const char *start, const char *end) {
+    if (!dst || dst_cap == 0) return;
+    size_t len = (end > start) ? (size_t)(end - start) : 0;
+    if (len >= dst_cap) len = dst_cap - 1;
+    memcpy(dst, start, len);
+    dst[len] = '\0';
+    trim_inplace(dst);
+}
+
+/* Set of fingerprints seen so far: open addressing with linear probing. The
+ * keys live back to back in one arena, so teardown is two frees. */
+typedef struct {
+    uint64_t hash;
+    size_t off;     /* arena offset of the key + 1, 0 = empty slot */
+} FpSlot;
+
+typedef struct {
+    FpSlot *slots;
+    size_t cap;     /* power of two */
+    size_t count;
+    char *arena;
+    size_t arena_len;
+    size_t arena_cap;
+} FpSet;
+
+static uint64_t fp_hash(const char *s, size_t len) {
+    /* FNV-1a */
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* expected: how many unique fingerprints the caller anticipates */
+static int fp_set_init(FpSet *set, size_t expected) {
+    memset(set, 0, sizeof(*set));
+    size_t cap = 64;
+    while (cap < expected * 2) cap *= 2;
+    set->slots = (FpSlot *)calloc(cap, sizeof(FpSlot));
+    set->arena_cap = (expected > 64 ? expected : 64) * 16;
+    set->arena = (char *)malloc(set->arena_cap);
+    if (!set->slots || !set->arena) {
+        free(set->slots);
+        free(set->arena);
+        return 0;
+    }
+    set->cap = cap;
+    return 1;
+}
+
+static int fp_set_grow(FpSet *set) {
+    size_t cap = set->cap * 2;
+    FpSlot *slots = (FpSlot *)calloc(cap, sizeof(FpSlot));
+    if (!slots) return 0;
+    for (size_t i = 0; i < set->cap; i++) {
+        if (!set->slots[i].off) continue;
+        size_t j = (size_t)set->slots[i].hash & (cap - 1);
+        while (slots[j].off) j = (j + 1) & (cap - 1);
+        slots[j] = set->slots[i];
+    }
+    free(set->slots);
+    set->slots = slots;
+    set->cap = cap;
+    return 1;
+}
+
+/* Returns 1 if fp was added, 0 if it was already present, -1 on allocation failure. */
+static int fp_set_insert(FpSet *set, const char *fp) {
+    size_t len = strlen(fp);
+    uint64_t h = fp_hash(fp, len);
+    size_t mask = set->cap - 1;
+    size_t i = (size_t)h & mask;
+    while (set->slots[i].off) {
+        if (set->slots[i].hash == h && strcmp(set->arena + set->slots[i].off - 1, fp) == 0) return 0;
+        i = (i + 1) & mask;
+    }
+
+    if (set->arena_len + len + 1 > set->arena_cap) {
+        size_t cap = set->arena_cap * 2;
+        while (set->arena_len + len + 1 > cap) cap *= 2;
+        char *tmp = (char *)realloc(set->arena, cap);
+        if (!tmp) return -1;
+        set->arena = tmp;
+        set->arena_cap = cap;
+    }
+    memcpy(set->arena + set->arena_len, fp, len + 1);
+    set->slots[i].hash = h;
+    set->slots[i].off = set->arena_len + 1;
+    set->arena_len += len + 1;
+    set->count++;
+
+    /* keep the load factor at or below 1/2 */
+    if (set->count * 2 > set->cap && !fp_set_grow(set)) return -1;
+    return 1;
+}
+
+static void fp_set_free(FpSet *set) {
+    free(set->slots);
+    free(set->arena);
+    set->slots = NULL;
+    set->arena = NULL;
+}
+
+static void normalize_position(char *pos) {
+    /* After cleaning we remove whitespace, so positions become RightHand, etc. */
+    if (strcmp(pos, "RightHand") == 0 || strcmp(pos, "Right_Hand") == 0) {
+        strcpy(pos, "Right Hand");
+    } else if (strcmp(pos, "LeftHand") == 0 || strcmp(pos, "Left_Hand") == 0) {
+        strcpy(pos, "Left Hand");
+    } else if (strcmp(pos, "SupportRight") == 0 || strcmp(pos, "Support_Right") == 0) {
+        strcpy(pos, "Support_Right");
+    } else if (strcmp(pos, "SupportLeft") == 0 || strcmp(pos, "Support_Left") == 0) {
+        strcpy(pos, "Support_Left");
+    }
+}
+
+struct Cleaner {
+    InputReader in;
+    CleanBuf cb;
+    Workers w;
+    FpSet seen;
+};
+
+/* Deduplicates e and hands it to the sink if it is new. Returns 0 on failure. */
+static int accept_entry(Cleaner *c, const CleanEntry *e, CleanSink sink, void *ctx) {
+    if (e->fingerprint[0] == '\0') return 1;
+
+    STAT_TIMER_START(STAT_DEDUP);
+    int added = fp_set_insert(&c->seen, e->fingerprint);
+    STAT_TIMER_STOP(STAT_DEDUP);
+    if (added < 0) {
+        printf("Memory allocation failed\n");
+        return 0;
+    }
+    if (!added) STAT_COUNT(STAT_DUPLICATES, 1);
+    return added ? sink(ctx, e) : 1;
+}
+
+/* Extracts every complete record from the cleaned buffer and drops the consumed
+ * prefix. The newly appended bytes are tokenized once into label offsets and
+ * records are cut from those offsets; a record is complete once the label
+ * starting the next one is known. On the final call the end of the stream
+ * terminates the last record. */
+static int parse_records(Cleaner *c, CleanBuf *cb, int final, Workers *w, CleanSink sink, void *ctx) {
+    /* labels starting in the last LABEL_MAX_LEN - 1 bytes may still be cut off */
+    size_t limit = cb->len;
+    if (!final) limit = (cb->len >= LABEL_MAX_LEN - 1) ? cb->len - (LABEL_MAX_LEN - 1) : 0;
+    if (limit < cb->scanned) limit = cb->scanned;
+    STAT_TIMER_START(STAT_LABEL_SCAN);
+    int scanned = scan_labels(cb, cb->scanned, limit, w);
+    STAT_TIMER_STOP(STAT_LABEL_SCAN);
+    if (!scanned) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    cb->scanned = limit;
+
+    const LabelHits *lh = &cb->labels;
+    const char *stream = cb->buf;
+    size_t p = 0;        /* next record search starts here */
+    size_t i = 0;        /* first label hit at or after p */
+    size_t keep;
+    int status = 1;
+
+    while (1) {
+        size_t i1 = label_find(lh, i, LABEL_FIRST_NAME, p);
+        if (i1 == lh->len) {
+            keep = (p > limit) ? p : limit;
+            if (final) status = 0;
+            break;
+        }
+        size_t f1 = lh->hits[i1].pos;
+        size_t v1 = f1 + label_len(LABEL_FIRST_NAME);
+        size_t i2 = label_find(lh, i1 + 1, LABEL_SECOND_NAME, v1);
+        size_t v2 = (i2 < lh->len) ? lh->hits[i2].pos + label_len(LABEL_SECOND_NAME) : 0;
+        size_t i3 = (i2 < lh->len) ? label_find(lh, i2 + 1, LABEL_FINGERPRINT, v2) : lh->len;
+        size_t v3 = (i3 < lh->len) ? lh->hits[i3].pos + label_len(LABEL_FINGERPRINT) : 0;
+        size_t i4 = (i3 < lh->len) ? label_find(lh, i3 + 1, LABEL_POSITION, v3) : lh->len;
+        size_t v4 = (i4 < lh->len) ? lh->hits[i4].pos + label_len(LABEL_POSITION) : 0;
+        /* Position value ends at next First Name or end of stream */
+        size_t inext = (i4 < lh->len) ? label_find(lh, i4 + 1, LABEL_FIRST_NAME, v4) : lh->len;
+        if (!final && inext == lh->len) {
+            /* record still incomplete: wait for more input */
+            keep = f1;
+            break;
+        }
+        if (i4 == lh->len) {
+            keep = cb->len;
+            status = 0;
+            break;
+        }
+        size_t next = (inext < lh->len) ? lh->hits[inext].pos : cb->len;
+
+        STAT_TIMER_START(STAT_RECORD_CUT);
+        CleanEntry e;
+        memset(&e, 0, sizeof(e));
+        copy_trimmed_range(e.first, sizeof(e.first), stream + v1, stream + lh->hits[i2].pos);
+        copy_trimmed_range(e.second, sizeof(e.second), stream + v2, stream + lh->hits[i3].pos);
+        copy_trimmed_range(e.fingerprint, sizeof(e.fingerprint), stream + v3, stream + lh->hits[i4].pos);
+        copy_trimmed_range(e.position, sizeof(e.position), stream + v4, stream + next);
+        normalize_position(e.position);
+
+        trim_inplace(e.fingerprint);
+        STAT_TIMER_STOP(STAT_RECORD_CUT);
+        STAT_COUNT(STAT_RECORDS, 1);
+        if (!accept_entry(c, &e, sink, ctx)) return -1;
+
+        p = v4;
+        i = i4 + 1;
+    }
+
+    memmove(cb->buf, cb->buf + keep, cb->len - keep + 1);
+    cb->len -= keep;
+    cb->scanned -= keep;
+    label_hits_discard(&cb->labels, keep);
+    return status;
+}
+
+/* Sizing hint for the fingerprint set, from the input size. A cleaned record
+ * is at least the 42 label bytes plus its values, so one per 64 input bytes
+ * over-estimates slightly and avoids rehashing on large files. */
+static size_t expected_records(const InputReader *in) {
+    size_t n = in->size / 64;
+    if (n > ((size_t)1 << 20)) n = (size_t)1 << 20;
+    return n;
+}
+
+Cleaner *cleaner_open(const char *path, int threads) {
+    Cleaner *c = (Cleaner *)calloc(1, sizeof(Cleaner));
+    if (!c) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    if (!reader_open(&c->in, path, CHUNK_SIZE)) {
+        printf("Error opening file: %s\n", path);
+        free(c);
+        return NULL;
+    }
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (c->in.size > 0 && (size_t)threads > (c->in.size - 1) / SLICE_SIZE + 1) {
+        threads = (int)((c->in.size - 1) / SLICE_SIZE + 1);
+    }
+    if (!workers_init(&c->w, threads) || (c->w.count > 1 && !reader_set_chunk(&c->in, c->w.raw_cap))) {
+        printf("Memory allocation failed\n");
+        reader_close(&c->in);
+        workers_free(&c->w);
+        free(c);
+        return NULL;
+    }
+    if (!fp_set_init(&c->seen, expected_records(&c->in))) {
+        printf("Memory allocation failed\n");
+        reader_close(&c->in);
+        workers_free(&c->w);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+int cleaner_read(Cleaner *c) {
+    return read_and_clean_stream(&c->in, &c->cb, &c->w);
+}
+
+int cleaner_parse(Cleaner *c, int final, CleanSink sink, void *ctx) {
+    return parse_records(c, &c->cb, final, &c->w, sink, ctx);
+}
+
+int cleaner_run(Cleaner *c, CleanSink sink, void *ctx) {
+    int more = 1;
+    int parsing = 1;
+    while (more && parsing) {
+        more = cleaner_read(c);
+        if (more < 0) return 0;
+        parsing = cleaner_parse(c, !more, sink, ctx);
+        if (parsing < 0) return 0;
+    }
+    return 1;
+}
+
+void cleaner_close(Cleaner *c) {
+    if (!c) return;
+    reader_close(&c->in);
+    free(c->cb.buf);
+    label_hits_free(&c->cb.labels);
+    fp_set_free(&c->seen);
+    workers_free(&c->w);
+    free(c);
+}
+
+int clean_position_rank(const char *pos) {
+    /* Output ordering requirement */
+    if (strcmp(pos, "Boss") == 0) return 0;
+    if (strcmp(pos, "RightHand") == 0 || strcmp(pos, "Right_Hand") == 0 || strcmp(pos, "Right Hand") == 0) return 1;
+    if (strcmp(pos, "LeftHand") == 0 || strcmp(pos, "Left_Hand") == 0 || strcmp(pos, "Left Hand") == 0) return 2;
+    if (strcmp(pos, "SupportRight") == 0 || strcmp(pos, "Support_Right") == 0 || strcmp(pos, "Support Right") == 0) return 3;
+    if (strcmp(pos, "SupportLeft") == 0 || strcmp(pos, "Support_Left") == 0 || strcmp(pos, "Support Left") == 0) return 4;
+    return 5;
+}
+
+
+static void write_field(OutBuf *out, const char *label, const char *value, const char *end) {
+    outbuf_puts(out, label);
+    outbuf_puts(out, value);
+    outbuf_puts(out, end);
+}
+
+static void write_values(OutBuf *out, const char *first, const char *second, const char *fingerprint,
+                         const char *position) {
+    write_field(out, "First Name: ", first, "\n");
+    write_field(out, "Second Name: ", second, "\n");
+    write_field(out, "Fingerprint: ", fingerprint, "\n");
+    write_field(out, "Position: ", position, "\n\n");
+}
+
+static void write_entry(OutBuf *out, const CleanEntry *e) {
+    write_values(out, e->first, e->second, e->fingerprint, e->position);
+}
+
+/* Entries that cannot be written yet, in output format, in a temporary file. */
+typedef struct {
+    FILE *file;
+    OutBuf ob;
+} Spill;
+
+static int spill_entry(Spill *spill, const CleanEntry *e) {
+    if (!spill->file) {
+        spill->file = tmpfile();
+        if (!spill->file || !outbuf_init_fd(&spill->ob, fileno(spill->file))) {
+            if (spill->file) fclose(spill->file);
+            spill->file = NULL;
+            printf("Error opening temporary file\n");
+            return 0;
+        }
+    }
+    write_entry(&spill->ob, e);
+    return 1;
+}
+
+/* Appends the spilled entries to out and discards the spill. */
+static int copy_spill(OutBuf *out, Spill *spill) {
+    if (!spill->file) return 1;
+    int ok = outbuf_flush(&spill->ob);
+    int fd = fileno(spill->file);
+    if (lseek(fd, 0, SEEK_SET) != 0) ok = 0;
+
+    /* the spill's write buffer is empty now; reuse it for reading */
+    ssize_t n = 0;
+    while (ok && (n = read(fd, spill->ob.buf, spill->ob.cap)) > 0) {
+        outbuf_put(out, spill->ob.buf, (size_t)n);
+    }
+    if (n < 0) ok = 0;
+
+    outbuf_close(&spill->ob);
+    fclose(spill->file);
+    spill->file = NULL;
+    return ok;
+}
+
+/* Streaming output state. Boss / Right Hand / Left Hand are written as soon as
+ * every position ranked before them has been written; supports that cannot be
+ * written yet are spilled to temporary files so memory stays bounded. */
+struct CleanWriter {
+    OutBuf out;
+
+    CleanEntry heads[3];  /* Boss, Right Hand, Left Hand */
+    int have_head[3];
+    int next_head;        /* heads[0..next_head) are already written */
+
+    Spill spill_right;
+    Spill spill_left;
+};
+
+static void advance_heads(CleanWriter *st) {
+    while (st->next_head < 3 && st->have_head[st->next_head]) {
+        write_entry(&st->out, &st->heads[st->next_head]);
+        st->next_head++;
+    }
+    if (st->next_head == 3) {
+        /* all heads are out: pending Support_Right entries can follow directly */
+        copy_spill(&st->out, &st->spill_right);
+    }
+}
+
+CleanWriter *clean_writer_open(const char *path) {
+    CleanWriter *st = (CleanWriter *)calloc(1, sizeof(CleanWriter));
+    if (!st) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    if (!outbuf_open(&st->out, path)) {
+        printf("Error opening file: %s\n", path);
+        free(st);
+        return NULL;
+    }
+    return st;
+}
+
+int clean_writer_add(void *writer, const CleanEntry *e) {
+    CleanWriter *st = (CleanWriter *)writer;
+    int ok = 1;
+    STAT_TIMER_START(STAT_ORDER);
+    int r = clean_position_rank(e->position);
+    if (r <= 2) {
+        if (!st->have_head[r]) {
+            st->heads[r] = *e;
+            st->have_head[r] = 1;
+            STAT_COUNT(STAT_ENTRIES_WRITTEN, 1);
+            advance_heads(st);
+        }
+    } else if (r == 3) {
+        if (st->next_head == 3) write_entry(&st->out, e);
+        else ok = spill_entry(&st->spill_right, e);
+        STAT_COUNT(STAT_ENTRIES_WRITTEN, 1);
+    } else if (r == 4) {
+        /* Support_Left goes last, so it can only be written at end of input */
+        ok = spill_entry(&st->spill_left, e);
+        STAT_COUNT(STAT_ENTRIES_WRITTEN, 1);
+    }
+    STAT_TIMER_STOP(STAT_ORDER);
+    return ok;
+}
+
+static void discard_spill(Spill *spill) {
+    if (!spill->file) return;
+    outbuf_close(&spill->ob);
+    fclose(spill->file);
+    spill->file = NULL;
+}
+
+int clean_writer_close(CleanWriter *st, int complete) {
+    if (!st) return 0;
+    int ok = 1;
+    STAT_TIMER_START(STAT_WRITE);
+    if (complete) {
+        /* Output in required order: whatever heads were not written yet, then supports */
+        for (int i = st->next_head; i < 3; i++) {
+            if (st->have_head[i]) write_entry(&st->out, &st->heads[i]);
+        }
+        ok &= copy_spill(&st->out, &st->spill_right);
+        ok &= copy_spill(&st->out, &st->spill_left);
+    }
+    ok &= outbuf_close(&st->out);
+    discard_spill(&st->spill_right);
+    discard_spill(&st->spill_left);
+    STAT_TIMER_STOP(STAT_WRITE);
+    free(st);
+    return ok;
+}
+
+/* ---- In-memory entries ---- */
+
+void clean_list_init(CleanList *l) {
+    memset(l, 0, sizeof(*l));
+}
+
+static int text_reserve(CleanText *t, size_t bytes) {
+    if (t->len + bytes > t->cap) {
+        size_t c = t->cap ? t->cap * 2 : 16384;
+        while (c < t->len + bytes) c *= 2;
+        char *tmp = (char *)realloc(t->text, c);
+        if (!tmp) return 0;
+        t->text = tmp;
+        t->cap = c;
+    }
+    if (t->count == t->start_cap) {
+        size_t c = t->start_cap ? t->start_cap * 2 : 256;
+        size_t *tmp = (size_t *)realloc(t->start, c * sizeof(size_t));
+        if (!tmp) return 0;
+        t->start = tmp;
+        t->start_cap = c;
+    }
+    return 1;
+}
+
+static void text_put(CleanText *t, const char *value) {
+    size_t n = strlen(value) + 1;
+    memcpy(t->text + t->len, value, n);
+    t->len += n;
+}
+
+static int text_push(CleanText *t, const CleanEntry *e) {
+    size_t bytes = strlen(e->first) + strlen(e->second) + strlen(e->fingerprint) + strlen(e->position) + 4;
+    if (!text_reserve(t, bytes)) {
+        printf("Memory allocation failed\n");
+        return 0;
+    }
+    t->start[t->count++] = t->len;
+    text_put(t, e->first);
+    text_put(t, e->second);
+    text_put(t, e->fingerprint);
+    text_put(t, e->position);
+    return 1;
+}
+
+static void text_free(CleanText *t) {
+    free(t->text);
+    free(t->start);
+    memset(t, 0, sizeof(*t));
+}
+
+int clean_list_add(void *list, const CleanEntry *e) {
+    CleanList *l = (CleanList *)list;
+    int ok = 1;
+    STAT_TIMER_START(STAT_ORDER);
+    int r = clean_position_rank(e->position);
+    if (r <= 2) {
+        if (!l->have_head[r]) {
+            l->heads[r] = *e;
+            l->have_head[r] = 1;
+        }
+    } else if (r == 3) {
+        ok = text_push(&l->right, e);
+    } else if (r == 4) {
+        ok = text_push(&l->left, e);
+    }
+    STAT_TIMER_STOP(STAT_ORDER);
+    return ok;
+}
+
+int clean_list_finish(CleanList *l) {
+    /* heads first, then the Support_Right arena, then the Support_Left one */
+    CleanText all;
+    memset(&all, 0, sizeof(all));
+    for (int i = 0; i < 3; i++) {
+        if (l->have_head[i] && !text_push(&all, &l->heads[i])) {
+            text_free(&all);
+            return 0;
+        }
+    }
+    const CleanText *parts[2] = { &l->right, &l->left };
+    for (int p = 0; p < 2; p++) {
+        const CleanText *t = parts[p];
+        size_t base = all.len;
+        size_t len = all.len + t->len;
+        size_t count = all.count + t->count;
+        char *text = (char *)realloc(all.text, len ? len : 1);
+        size_t *start = (size_t *)realloc(all.start, (count ? count : 1) * sizeof(size_t));
+        if (text) all.text = text;
+        if (start) all.start = start;
+        if (!text || !start) {
+            printf("Memory allocation failed\n");
+            text_free(&all);
+            return 0;
+        }
+        if (t->len) memcpy(all.text + base, t->text, t->len);
+        for (size_t i = 0; i < t->count; i++) all.start[all.count + i] = base + t->start[i];
+        all.len = all.cap = len;
+        all.count = all.start_cap = count;
+    }
+    text_free(&l->right);
+    text_free(&l->left);
+    text_free(&l->entries);
+    l->entries = all;
+    memset(l->have_head, 0, sizeof(l->have_head));
+    return 1;
+}
+
+/* Writes every entry of t in clean-file format. Returns how many. */
+static size_t write_text(OutBuf *out, const CleanText *t) {
+    for (size_t i = 0; i < t->count; i++) {
+        const char *p = t->text + t->start[i];
+        const char *first = p;
+        p += strlen(p) + 1;
+        const char *second = p;
+        p += strlen(p) + 1;
+        const char *fingerprint = p;
+        p += strlen(p) + 1;
+        write_values(out, first, second, fingerprint, p);
+    }
+    return t->count;
+}
+
+int clean_list_write(const CleanList *l, const char *path) {
+    OutBuf out;
+    if (!outbuf_open(&out, path)) {
+        printf("Error opening file: %s\n", path);
+        return 0;
+    }
+    STAT_TIMER_START(STAT_WRITE);
+    size_t n = write_text(&out, &l->entries);
+    for (int i = 0; i < 3; i++) {
+        if (!l->have_head[i]) continue;
+        write_entry(&out, &l->heads[i]);
+        n++;
+    }
+    n += write_text(&out, &l->right);
+    n += write_text(&out, &l->left);
+    int ok = outbuf_close(&out);
+    STAT_TIMER_STOP(STAT_WRITE);
+    STAT_COUNT(STAT_ENTRIES_WRITTEN, n);
+    if (!ok) printf("Error writing file: %s\n", path);
+    return ok;
+}
+
+void clean_list_free(CleanList *l) {
+    if (!l) return;
+    text_free(&l->entries);
+    text_free(&l->right);
+    text_free(&l->left);
+    clean_list_init(l);
+}
+
+int clean_file_entries(const char *path, int threads, CleanList *list) {
+    clean_list_init(list);
+    Cleaner *c = cleaner_open(path, threads);
+    if (!c) return 0;
+    int ok = cleaner_run(c, clean_list_add, list) && clean_list_finish(list);
+    cleaner_close(c);
+    if (!ok) clean_list_free(list);
+    return ok;
+}
+
+/* ---- Checkpoints ----
+ * File = 64-byte header followed by CKPT_PARTS parts, each an 8-byte length
+ * and its bytes padded to 8: the cleaned bytes carried over, the fingerprint
+ * set (slot table as-is, then the key arena), the CleanList heads and their
+ * flags, and the two support arenas with their start offsets. As in the org
+ * snapshots, fields are in host byte order and the byte_order marker
+ * rejects files from a host with the other one. */
+#define CKPT_MAGIC    "CLEANCK"
+#define CKPT_VERSION  1u
+#define CKPT_BOM      0x01020304u
+#define CKPT_PARTS    9
+#define CKPT_SIG_SPAN 4096
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t input_pos;     /* input bytes consumed */
+    uint64_t input_sig;     /* input_signature() at input_pos */
+    uint32_t ended;         /* input stopped at an embedded NUL */
+    uint32_t parts;
+    uint64_t body_len;
+    uint64_t checksum;
+    uint8_t reserved[8];
+} CkptHeader;
+
+typedef struct {
+    const void *data;
+    size_t len;
+} CkptPart;
+
+/* FNV-1a over 64-bit words, the last one zero padded. */
+static uint64_t ckpt_hash(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h ^= w;
+        h *= 1099511628211ULL;
+    }
+    if (i < len) {
+        uint64_t w = 0;
+        memcpy(&w, p + i, len - i);
+        h ^= w;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Hash of the CKPT_SIG_SPAN input bytes ending at pos, to notice an input
+ * that was replaced rather than appended to. Returns 0 if they cannot be read. */
+static int input_signature(const InputReader *in, size_t pos, uint64_t *sig) {
+    char buf[CKPT_SIG_SPAN];
+    size_t n = pos < sizeof(buf) ? pos : sizeof(buf);
+    if (in->map) {
+        if (pos > in->map_len) return 0;
+        memcpy(buf, in->map + pos - n, n);
+    } else if (n > 0 && pread(in->fd, buf, n, (off_t)(pos - n)) != (ssize_t)n) {
+        return 0;
+    }
+    uint64_t len = pos;
+    *sig = ckpt_hash(ckpt_hash(1469598103934665603ULL, &len, sizeof(len)), buf, n);
+    return 1;
+}
+
+int cleaner_feed(Cleaner *c, CleanSink sink, void *ctx) {
+    int more = 1;
+    while (more) {
+        more = cleaner_read(c);
+        if (more < 0 || cleaner_parse(c, 0, sink, ctx) < 0) return 0;
+    }
+    return 1;
+}
+
+int cleaner_checkpoint(const Cleaner *c, const CleanList *list, const char *path) {
+    const FpSet *set = &c->seen;
+    CkptPart parts[CKPT_PARTS] = {
+        { c->cb.buf, c->cb.len },
+        { set->slots, set->cap * sizeof(FpSlot) },
+        { set->arena, set->arena_len },
+        { list->have_head, sizeof(list->have_head) },
+        { list->heads, sizeof(list->heads) },
+        { list->right.text, list->right.len },
+        { list->right.start, list->right.count * sizeof(size_t) },
+        { list->left.text, list->left.len },
+        { list->left.start, list->left.count * sizeof(size_t) },
+    };
+
+    CkptHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CKPT_MAGIC, sizeof(CKPT_MAGIC));
+    hdr.version = CKPT_VERSION;
+    hdr.byte_order = CKPT_BOM;
+    hdr.input_pos = c->in.pos;
+    hdr.ended = (uint32_t)c->cb.ended;
+    hdr.parts = CKPT_PARTS;
+    if (!input_signature(&c->in, c->in.pos, &hdr.input_sig)) {
+        printf("Error reading the input file\n");
+        return 0;
+    }
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < CKPT_PARTS; i++) {
+        uint64_t len = parts[i].len;
+        h = ckpt_hash(ckpt_hash(h, &len, sizeof(len)), parts[i].data, parts[i].len);
+        hdr.body_len += sizeof(len) + (len + 7) / 8 * 8;
+    }
+    hdr.checksum = h;
+
+    /* written next to the old checkpoint and renamed over it, so a run that
+     * dies half way leaves the previous one intact */
+    size_t plen = strlen(path);
+    char *tmp_path = (char *)malloc(plen + 5);
+    if (!tmp_path) {
+        printf("Memory allocation failed\n");
+        return 0;
+    }
+    memcpy(tmp_path, path, plen);
+    memcpy(tmp_path + plen, ".tmp", 5);
+
+    OutBuf ob;
+    if (!outbuf_open(&ob, tmp_path)) {
+        printf("Error opening file: %s\n", tmp_path);
+        free(tmp_path);
+        return 0;
+    }
+    static const char pad[8];
+    outbuf_put(&ob, (const char *)&hdr, sizeof(hdr));
+    for (int i = 0; i < CKPT_PARTS; i++) {
+        uint64_t len = parts[i].len;
+        outbuf_put(&ob, (const char *)&len, sizeof(len));
+        if (len) outbuf_put(&ob, (const char *)parts[i].data, parts[i].len);
+        outbuf_put(&ob, pad, (8 - len % 8) % 8);
+    }
+    int ok = outbuf_close(&ob);
+    if (ok && rename(tmp_path, path) != 0) ok = 0;
+    if (!ok) {
+        printf("Error writing file: %s\n", path);
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    return ok;
+}
+
+/* Next part of a checkpoint body at *p. Returns 0 if it runs past end. */
+static int ckpt_next(const char **p, const char *end, CkptPart *part) {
+    uint64_t len;
+    if ((size_t)(end - *p) < sizeof(len)) return 0;
+    memcpy(&len, *p, sizeof(len));
+    *p += sizeof(len);
+    if (len > (uint64_t)(end - *p) || (len + 7) / 8 * 8 > (uint64_t)(end - *p)) return 0;
+    part->data = *p;
+    part->len = (size_t)len;
+    *p += (len + 7) / 8 * 8;
+    return 1;
+}
+
+static int ckpt_text_ok(const CkptPart *text, const CkptPart *start) {
+    if (start->len % sizeof(size_t)) return 0;
+    if (text->len == 0) return start->len == 0;
+    if (((const char *)text->data)[text->len - 1] != '\0') return 0;
+    for (size_t i = 0; i < start->len / sizeof(size_t); i++) {
+        size_t s;
+        memcpy(&s, (const char *)start->data + i * sizeof(size_t), sizeof(s));
+        if (s >= text->len) return 0;
+    }
+    return 1;
+}
+
+static int ckpt_heads_ok(const CkptPart *have, const CkptPart *heads) {
+    if (have->len != sizeof(int) * 3 || heads->len != sizeof(CleanEntry) * 3) return 0;
+    const CleanEntry *e = (const CleanEntry *)heads->data;
+    for (int i = 0; i < 3; i++) {
+        if (!memchr(e[i].first, '\0', CLEAN_MAX_VAL) || !memchr(e[i].second, '\0', CLEAN_MAX_VAL) ||
+            !memchr(e[i].fingerprint, '\0', CLEAN_MAX_VAL) || !memchr(e[i].position, '\0', CLEAN_MAX_VAL)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Fingerprint set from its parts, or 0 if they do not make one. */
+static int ckpt_set_ok(const CkptPart *slots, const CkptPart *arena, size_t *count) {
+    size_t cap = slots->len / sizeof(FpSlot);
+    if (slots->len % sizeof(FpSlot) || cap < 64 || (cap & (cap - 1))) return 0;
+    if (arena->len && ((const char *)arena->data)[arena->len - 1] != '\0') return 0;
+    *count = 0;
+    for (size_t i = 0; i < cap; i++) {
+        FpSlot s;
+        memcpy(&s, (const char *)slots->data + i * sizeof(FpSlot), sizeof(s));
+        if (!s.off) continue;
+        if (s.off > arena->len) return 0;
+        (*count)++;
+    }
+    return *count * 2 <= cap;
+}
+
+static void *copy_part(const CkptPart *part, size_t cap) {
+    char *p = (char *)malloc(cap ? cap : 1);
+    if (p && part->len) memcpy(p, part->data, part->len);
+    return p;
+}
+
+static int copy_text(CleanText *t, const CkptPart *text, const CkptPart *start) {
+    t->len = t->cap = text->len;
+    t->count = t->start_cap = start->len / sizeof(size_t);
+    t->text = (char *)copy_part(text, text->len);
+    t->start = (size_t *)copy_part(start, start->len);
+    return t->text && t->start;
+}
+
+int cleaner_resume(Cleaner *c, CleanList *list, const char *path) {
+    if (access(path, F_OK) != 0) return 0;
+    InputSpan span;
+    if (!span_open(&span, path)) {
+        printf("Error opening file: %s\n", path);
+        return -1;
+    }
+
+    CkptHeader hdr;
+    CkptPart parts[CKPT_PARTS];
+    int valid = span.len >= sizeof(hdr);
+    if (valid) memcpy(&hdr, span.data, sizeof(hdr));
+    valid = valid && memcmp(hdr.magic, CKPT_MAGIC, sizeof(CKPT_MAGIC)) == 0 && hdr.version == CKPT_VERSION &&
+            hdr.byte_order == CKPT_BOM && hdr.parts == CKPT_PARTS && hdr.body_len == span.len - sizeof(hdr);
+    const char *p = span.data + sizeof(hdr), *end = span.data + span.len;
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; valid && i < CKPT_PARTS; i++) {
+        valid = ckpt_next(&p, end, &parts[i]);
+        uint64_t len = parts[i].len;
+        if (valid) h = ckpt_hash(ckpt_hash(h, &len, sizeof(len)), parts[i].data, parts[i].len);
+    }
+    size_t fp_count = 0;
+    valid = valid && p == end && h == hdr.checksum && ckpt_set_ok(&parts[1], &parts[2], &fp_count) &&
+            ckpt_heads_ok(&parts[3], &parts[4]) && ckpt_text_ok(&parts[5], &parts[6]) &&
+            ckpt_text_ok(&parts[7], &parts[8]);
+    if (!valid) {
+        printf("Invalid checkpoint: %s\n", path);
+        span_close(&span);
+        return 0;
+    }
+
+    /* the input must be the checkpointed one with data appended */
+    uint64_t sig;
+    if (c->in.pos != 0 || c->in.size < hdr.input_pos ||
+        !input_signature(&c->in, (size_t)hdr.input_pos, &sig) || sig != hdr.input_sig) {
+        printf("Input changed since the checkpoint, cleaning it from the start\n");
+        span_close(&span);
+        return 0;
+    }
+
+    CleanBuf *cb = &c->cb;
+    size_t tail = parts[0].len;
+    char *buf = (char *)copy_part(&parts[0], tail + 1 + BYTE_FILTER_SLACK);
+    FpSlot *slots = (FpSlot *)copy_part(&parts[1], parts[1].len);
+    size_t arena_cap = parts[2].len > 1024 ? parts[2].len * 2 : 1024;
+    char *arena = (char *)copy_part(&parts[2], arena_cap);
+    CleanList l;
+    clean_list_init(&l);
+    memcpy(l.have_head, parts[3].data, sizeof(l.have_head));
+    memcpy(l.heads, parts[4].data, sizeof(l.heads));
+    int ok = buf && slots && arena && copy_text(&l.right, &parts[5], &parts[6]) &&
+             copy_text(&l.left, &parts[7], &parts[8]) && reader_skip(&c->in, (size_t)hdr.input_pos);
+    span_close(&span);
+    if (!ok) {
+        printf("Memory allocation failed\n");
+        free(buf);
+        free(slots);
+        free(arena);
+        clean_list_free(&l);
+        return -1;
+    }
+
+    free(cb->buf);
+    cb->buf = buf;
+    cb->len = tail;
+    cb->cap = tail + 1 + BYTE_FILTER_SLACK;
+    cb->buf[tail] = '\0';
+    cb->labels.len = 0;
+    cb->scanned = 0;
+    cb->ended = (int)hdr.ended;
+
+    fp_set_free(&c->seen);
+    c->seen.slots = slots;
+    c->seen.cap = parts[1].len / sizeof(FpSlot);
+    c->seen.count = fp_count;
+    c->seen.arena = arena;
+    c->seen.arena_len = parts[2].len;
+    c->seen.arena_cap = arena_cap;
+
+    clean_list_free(list);
+    *list = l;
+    return 1;
+}
@@ -0,0 +1,134 @@
+#ifndef CLEANER_H
+#define CLEANER_H
+
+#include <stddef.h>
+#include <string.h>
+
+/* The ex1 cleaner as two stages over a corrupted dump:
+ *   cleaner_read  - next chunk (or -j window) of input, corruption characters
+ *                   and whitespace filtered out, appended to the clean buffer
+ *   cleaner_parse - every complete record cut out of the clean buffer, its
+ *                   fingerprint deduplicated, new entries handed to a sink
+ * A CleanWriter is the sink ex1 uses: it writes entries to the clean file in
+ * the required position order. */
+
+#define CLEAN_MAX_VAL 128
+
+typedef struct {
+    char first[CLEAN_MAX_VAL];
+    char second[CLEAN_MAX_VAL];
+    char fingerprint[CLEAN_MAX_VAL];
+    char position[CLEAN_MAX_VAL];   // normalized ("Right Hand", "Support_Left", ...)
+} CleanEntry;
+
+/* Receives each entry with a fingerprint not seen before, in input order.
+ * Returns 0 to fail the run. */
+typedef int (*CleanSink)(void *ctx, const CleanEntry *e);
+
+typedef struct Cleaner Cleaner;
+
+/* threads > 1 filters and tokenizes each window of input concurrently; the
+ * entries come out the same either way. At most 256 threads are used, and
+ * no more than the input has 4 MiB slices when its size is known. Returns
+ * NULL on failure (message printed). */
+Cleaner *cleaner_open(const char *path, int threads);
+/* Returns 1 if more input may follow, 0 at end of input, -1 on failure. */
+int cleaner_read(Cleaner *c);
+/* final: no more input will be read, so the last record ends at the end of
+ * the buffer. Returns 1 while parsing may continue, 0 when parsing is over,
+ * -1 on failure. */
+int cleaner_parse(Cleaner *c, int final, CleanSink sink, void *ctx);
+/* Both stages until the end of input. Returns 1 on success, 0 on failure. */
+int cleaner_run(Cleaner *c, CleanSink sink, void *ctx);
+void cleaner_close(Cleaner *c);
+
+/* Position order of the clean file: Boss, Right Hand, Left Hand,
+ * Support_Right, Support_Left; anything else ranks 5 and is not written. */
+int clean_position_rank(const char *position);
+
+typedef struct CleanWriter CleanWriter;
+
+/* Returns NULL if path cannot be opened (message printed). */
+CleanWriter *clean_writer_open(const char *path);
+/* CleanSink: keeps the first Boss / Hand of each kind and every support. */
+int clean_writer_add(void *writer, const CleanEntry *e);
+/* complete: the run succeeded, so write what is still held back in order.
+ * Returns 1 if everything reached the file. */
+int clean_writer_close(CleanWriter *w, int complete);
+
+/* Entries packed back to back in one arena: first, second name,
+ * fingerprint and position, each NUL terminated; start[i] is where entry i
+ * begins. */
+typedef struct {
+    char *text;
+    size_t len, cap;
+    size_t *start;
+    size_t count, start_cap;
+} CleanText;
+
+/* In-memory counterpart of CleanWriter: keeps the same entries, and once
+ * clean_list_finish() has run they are in clean-file order in entries. The
+ * other fields are collection state. */
+typedef struct CleanList {
+    CleanText entries;
+
+    CleanEntry heads[3];    // Boss, Right Hand, Left Hand
+    int have_head[3];
+    CleanText right;        // supports, in input order
+    CleanText left;
+} CleanList;
+
+/* Values of one entry, pointing into the list. */
+typedef struct {
+    const char *first;
+    const char *second;
+    const char *fingerprint;
+    const char *position;
+} CleanRef;
+
+void clean_list_init(CleanList *l);
+/* CleanSink: same selection as clean_writer_add. */
+int clean_list_add(void *list, const CleanEntry *e);
+/* Puts the collected entries in order. Returns 0 on allocation failure
+ * (message printed). */
+int clean_list_finish(CleanList *l);
+/* Entry i (< l->entries.count) of a finished list. */
+static inline void clean_list_get(const CleanList *l, size_t i, CleanRef *ref) {
+    const char *p = l->entries.text + l->entries.start[i];
+    ref->first = p;
+    p += strlen(p) + 1;
+    ref->second = p;
+    p += strlen(p) + 1;
+    ref->fingerprint = p;
+    p += strlen(p) + 1;
+    ref->position = p;
+}
+/* Writes the list as a clean file, byte for byte what ex1 writes; it need
+ * not be finished. Returns 1 on success, 0 on failure (message printed). */
+int clean_list_write(const CleanList *l, const char *path);
+void clean_list_free(CleanList *l);
+
+/* The whole ex1 run without the output file: cleans path and leaves the
+ * ordered entries in list. Returns 1 on success, 0 on failure (message
+ * printed, list empty). */
+int clean_file_entries(const char *path, int threads, CleanList *list);
+
+/* Incremental runs over an input that is only ever appended to (ex1
+ * --incremental). A checkpoint holds how far the input was consumed, the
+ * cleaned bytes of the record still open there, every fingerprint seen and
+ * the CleanList of entries kept, so the next run reads only the new bytes.
+ *
+ * cleaner_resume: right after cleaner_open, restores c and list from the
+ * checkpoint at path. Returns 1 if restored; 0 if there is none or it does
+ * not fit this input (message printed unless it does not exist), c and list
+ * untouched; -1 on failure (message printed).
+ * cleaner_feed: reads and parses the rest of the input but leaves the last
+ * record open, as more may be appended to it. Returns 1 on success, 0 on
+ * failure. cleaner_parse(c, 1, ...) afterwards closes it for this run.
+ * cleaner_checkpoint: saves the state after cleaner_feed. Returns 1 on
+ * success, 0 on failure (message printed). */
+int cleaner_resume(Cleaner *c, CleanList *list, const char *path);
+int cleaner_feed(Cleaner *c, CleanSink sink, void *ctx);
+int cleaner_checkpoint(const Cleaner *c, const CleanList *list, const char *path);
+
+#endif // CLEANER_H
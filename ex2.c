@@ -2,131 +2,516 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "org_tree.h"
+#include "io_buf.h"
+#include "mask_match.h"
+#include "org_search.h"
+#include "key_search.h"
+#include "cipher_reader.h"
+#include "stats.h"
 
 #define FP_LEN 9
 
-static void print_success(int mask, char *op, char* fingerprint, char* First_Name, char* Second_Name)
-{
-    printf("Successful Decrypt! The Mask used was mask_%d of type (%s) and The fingerprint was %.*s belonging to %s %s\n",
-           mask, op, FP_LEN, fingerprint, First_Name, Second_Name);
+enum { CIPHER_OK, CIPHER_OPEN_ERROR, CIPHER_INVALID };
+
+/* Reads the first cipher of a cipher file in any format (see
+ * cipher_reader.h). Returns one of CIPHER_*. */
+static int load_cipher(const char *path, CipherFormat fmt, uint8_t out_bytes[FP_LEN]) {
+    CipherReader r;
+    STAT_TIMER_START(STAT_CIPHER_READ);
+    int opened = cipher_reader_open(&r, path, fmt);
+    uint8_t one[1][CIPHER_LEN];
+    size_t n = opened ? cipher_reader_next(&r, one, 1) : 0;
+    if (opened) cipher_reader_close(&r);
+    STAT_TIMER_STOP(STAT_CIPHER_READ);
+    if (!opened) return CIPHER_OPEN_ERROR;
+    if (n != 1) return CIPHER_INVALID;
+    memcpy(out_bytes, one[0], FP_LEN);
+    return CIPHER_OK;
 }
 
-static void print_unsuccess()
-{
-    printf("Unsuccesful decrypt, Looks like he got away\n");
+static int read_cipher(const char *path, CipherFormat fmt, uint8_t out_bytes[FP_LEN]) {
+    int status = load_cipher(path, fmt, out_bytes);
+    if (status == CIPHER_OPEN_ERROR) printf("Error opening file: %s\n", path);
+    return status == CIPHER_OK;
 }
 
-static int read_cipher_bits(const char *path, uint8_t out_bytes[FP_LEN]) {
-    FILE *fp = fopen(path, "r");
-    if (!fp) {
+/* Every cipher of a multi-cipher file, parsed in batches. *bad is the number
+ * of a malformed record that ended the input, or -1. Returns 0 if the file
+ * cannot be opened or memory runs out (message printed). */
+#define CIPHER_BATCH 4096
+
+static int read_cipher_stream(const char *path, CipherFormat fmt, uint8_t (**out)[CIPHER_LEN], size_t *n, long *bad) {
+    CipherReader r;
+    *out = NULL;
+    *n = 0;
+    *bad = -1;
+    if (!cipher_reader_open(&r, path, fmt)) {
         printf("Error opening file: %s\n", path);
         return 0;
     }
-
-    char line[128];
-    int count = 0;
-    while (count < FP_LEN && fgets(line, sizeof(line), fp)) {
-        /* trim */
-        size_t n = strcspn(line, "\r\n");
-        line[n] = '\0';
-        if (line[0] == '\0') continue;
-        if (strlen(line) < 8) continue;
-
-        uint8_t v = 0;
-        for (int i = 0; i < 8; i++) {
-            v <<= 1;
-            if (line[i] == '1') v |= 1;
-            else if (line[i] != '0') {
-                /* invalid char - treat as failure */
-                fclose(fp);
+    size_t cap = 0;
+    while (1) {
+        if (*n + CIPHER_BATCH > cap) {
+            size_t c = cap ? cap * 2 : CIPHER_BATCH;
+            uint8_t (*tmp)[CIPHER_LEN] = (uint8_t (*)[CIPHER_LEN])realloc(*out, c * CIPHER_LEN);
+            if (!tmp) {
+                printf("Memory allocation failed\n");
+                cipher_reader_close(&r);
                 return 0;
             }
+            *out = tmp;
+            cap = c;
         }
-        out_bytes[count++] = v;
+        size_t got = cipher_reader_next(&r, *out + *n, CIPHER_BATCH);
+        *n += got;
+        if (got < CIPHER_BATCH) break;
+    }
+    if (r.error) *bad = (long)r.records;
+    cipher_reader_close(&r);
+    return 1;
+}
+
+typedef struct {
+    int solve;          /* analytic solver instead of the mask loop */
+    int full_range;     /* solver over masks 0..255 */
+    int extended;       /* key search engine with the settings below */
+    KeySearch keys;
+} SearchMode;
+
+/* Wider keys, other operators or an explicit key range go through the key
+ * search engine; single byte XOR/AND keeps the paths above. */
+static Solution search_keys(const OrgFlat *org, const uint8_t cipher[FP_LEN], const KeySearch *ks) {
+    Solution sol = { -1, 0, OP_XOR };
+    KeyMatch m;
+    int r = key_search(ks, org->fingerprints[0], ORG_FP_WIDTH, org->count, cipher, &m);
+    if (r < 0) {
+        printf("Memory allocation failed\n");
+    } else if (r > 0) {
+        sol.node = m.node;
+        sol.mask = m.key;
+        sol.op = ks->ops[m.op]->name;
     }
+    return sol;
+}
 
-    fclose(fp);
-    return count == FP_LEN;
+static Solution decrypt(const OrgFlat *org, const OrgIndex *ix, const uint8_t cipher[FP_LEN], int s,
+                        const SearchMode *mode) {
+    Solution sol;
+    STAT_TIMER_START(STAT_MASK_SEARCH);
+    if (mode->extended) sol = search_keys(org, cipher, &mode->keys);
+    else if (!mode->solve) sol = find_match_in_org(org, ix, cipher, s);
+    else if (mode->full_range) sol = solve_masks(org, cipher, 0, 255);
+    else sol = solve_masks(org, cipher, s, s + 10);
+    STAT_TIMER_STOP(STAT_MASK_SEARCH);
+    STAT_COUNT(STAT_CIPHERS, 1);
+    if (sol.node >= 0) STAT_COUNT(STAT_MATCHES, 1);
+    return sol;
 }
 
-static int fingerprint_matches(const char fp[FP_LEN + 1], const uint8_t cipher[FP_LEN], int mask, int use_xor) {
-    for (int i = 0; i < FP_LEN; i++) {
-        uint8_t plain = (uint8_t)fp[i];
-        uint8_t enc = use_xor ? (uint8_t)(plain ^ (uint8_t)mask) : (uint8_t)(plain & (uint8_t)mask);
-        if (enc != cipher[i]) return 0;
+static void report_result(const OrgFlat *org, const Solution *sol) {
+    char line[SOLUTION_LINE_MAX];
+    fwrite(line, 1, format_solution(line, sizeof(line), org, sol), stdout);
+}
+
+/* Loads the org from a snapshot, or parses it when path is a clean text file,
+ * and builds its fingerprint index into ix unless ix is NULL (ix is always
+ * safe to org_index_free). Returns 1 if there is an org (with a Boss) to search. */
+static int load_org(const char *path, OrgFlat *org, OrgIndex *ix) {
+    if (ix) memset(ix, 0, sizeof(*ix));
+    STAT_TIMER_START(STAT_ORG_READ);
+    int r = load_org_snapshot(path, org);
+    STAT_TIMER_STOP(STAT_ORG_READ);
+    if (r < 0) return 0;
+    if (r == 0) {
+        Org tree = build_org_from_clean_file(path);
+        if (!tree.boss) {
+            /* build_org_from_clean_file prints file error if any */
+            free_org(&tree);
+            return 0;
+        }
+        STAT_TIMER_START(STAT_ORG_INDEX);
+        int ok = org_flat_from_org(&tree, org);
+        free_org(&tree);
+        STAT_TIMER_STOP(STAT_ORG_INDEX);
+        if (!ok) {
+            printf("Memory allocation failed\n");
+            return 0;
+        }
+    }
+    if (org->count == 0) return 0;
+    STAT_TIMER_START(STAT_ORG_INDEX);
+    int indexed = !ix || org_index_build_flat(org, ix);
+    STAT_TIMER_STOP(STAT_ORG_INDEX);
+    if (!indexed) {
+        printf("Memory allocation failed\n");
+        return 0;
     }
     return 1;
 }
 
-static Node *find_match_in_org(const Org *org, const uint8_t cipher[FP_LEN], int mask, int use_xor) {
-    if (!org || !org->boss) return NULL;
+/* ---- Batch mode ----
+ * One loaded org, many cipher files (or the records of one cipher stream):
+ * workers pull the next cipher index from a shared counter, results are
+ * stored per index and printed in input order. */
+typedef struct {
+    const char *path;
+    long record;        /* record number within a cipher stream, -1 for a cipher file */
+    uint8_t cipher[FP_LEN];
+    int status;         /* CIPHER_* */
+    Solution sol;
+    double latency_us;
+} BatchItem;
 
-    /* check boss */
-    if (fingerprint_matches(org->boss->fingerprint, cipher, mask, use_xor)) return org->boss;
+typedef struct {
+    const OrgFlat *org;
+    const OrgIndex *index;
+    const SearchMode *mode;
+    CipherFormat fmt;
+    int s;
+    BatchItem *items;
+    size_t count;
+    atomic_size_t next;
+} BatchJob;
 
-    /* check left hand + supports */
-    if (org->left_hand && fingerprint_matches(org->left_hand->fingerprint, cipher, mask, use_xor)) return org->left_hand;
-    if (org->left_hand) {
-        Node *s = org->left_hand->supports_head;
-        while (s) {
-            if (fingerprint_matches(s->fingerprint, cipher, mask, use_xor)) return s;
-            s = s->next;
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static void *batch_worker(void *arg) {
+    BatchJob *job = (BatchJob *)arg;
+    size_t i;
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->count) {
+        BatchItem *it = &job->items[i];
+        double t0 = now_us();
+        /* stream records are parsed up front */
+        if (it->record < 0) it->status = load_cipher(it->path, job->fmt, it->cipher);
+        if (it->status == CIPHER_OK) it->sol = decrypt(job->org, job->index, it->cipher, job->s, job->mode);
+        it->latency_us = now_us() - t0;
+    }
+    return NULL;
+}
+
+static int push_path(char ***paths, size_t *n, size_t *cap, const char *p, size_t len) {
+    if (*n == *cap) {
+        size_t c = *cap ? *cap * 2 : 64;
+        char **tmp = (char **)realloc(*paths, c * sizeof(char *));
+        if (!tmp) return 0;
+        *paths = tmp;
+        *cap = c;
+    }
+    char *s = (char *)malloc(len + 1);
+    if (!s) return 0;
+    memcpy(s, p, len);
+    s[len] = '\0';
+    (*paths)[(*n)++] = s;
+    return 1;
+}
+
+static int cmp_paths(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Cipher paths from a directory (sorted by name), a manifest file with one
+ * path per line, or "-" for a manifest on stdin. Returns 0 on failure. */
+static int collect_cipher_paths(const char *src, char ***paths, size_t *n) {
+    size_t cap = 0;
+    *paths = NULL;
+    *n = 0;
+
+    struct stat sb;
+    if (strcmp(src, "-") != 0 && stat(src, &sb) == 0 && S_ISDIR(sb.st_mode)) {
+        DIR *dir = opendir(src);
+        if (!dir) return 0;
+        struct dirent *de;
+        size_t dlen = strlen(src);
+        while ((de = readdir(dir)) != NULL) {
+            if (de->d_name[0] == '.') continue;
+            size_t len = dlen + 1 + strlen(de->d_name);
+            char *full = (char *)malloc(len + 1);
+            if (!full) break;
+            snprintf(full, len + 1, "%s/%s", src, de->d_name);
+            int ok = push_path(paths, n, &cap, full, len);
+            free(full);
+            if (!ok) break;
         }
+        closedir(dir);
+        qsort(*paths, *n, sizeof(char *), cmp_paths);
+        return 1;
+    }
+
+    InputSpan span;
+    if (!span_open(&span, strcmp(src, "-") == 0 ? "/dev/stdin" : src)) return 0;
+    const char *p = span.data;
+    const char *end = span.data + span.len;
+    while (p < end) {
+        const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+        const char *e = nl ? nl : end;
+        const char *b = p;
+        p = nl ? nl + 1 : end;
+        while (b < e && (*b == ' ' || *b == '\t')) b++;
+        while (e > b && (e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')) e--;
+        if (e > b && !push_path(paths, n, &cap, b, (size_t)(e - b))) break;
     }
+    span_close(&span);
+    return 1;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
 
-    /* check right hand + supports */
-    if (org->right_hand && fingerprint_matches(org->right_hand->fingerprint, cipher, mask, use_xor)) return org->right_hand;
-    if (org->right_hand) {
-        Node *s = org->right_hand->supports_head;
-        while (s) {
-            if (fingerprint_matches(s->fingerprint, cipher, mask, use_xor)) return s;
-            s = s->next;
+/* list names cipher files (collect_cipher_paths), or with stream set is
+ * itself one multi-cipher file. */
+static int run_batch(const OrgFlat *org, const OrgIndex *ix, const char *list, int stream, CipherFormat fmt,
+                     int s, const SearchMode *mode, int threads) {
+    char **paths = NULL;
+    size_t npaths = 0, n;
+    uint8_t (*ciphers)[CIPHER_LEN] = NULL;
+    long bad = -1;
+    if (stream) {
+        STAT_TIMER_START(STAT_CIPHER_READ);
+        int ok = read_cipher_stream(list, fmt, &ciphers, &n, &bad);
+        STAT_TIMER_STOP(STAT_CIPHER_READ);
+        if (!ok) return 0;
+        if (bad >= 0) n++;      /* the malformed record gets its own line */
+    } else {
+        if (!collect_cipher_paths(list, &paths, &npaths)) {
+            printf("Error opening file: %s\n", list);
+            return 0;
         }
+        n = npaths;
     }
 
-    return NULL;
+    BatchJob job;
+    job.org = org;
+    job.index = ix;
+    job.mode = mode;
+    job.fmt = fmt;
+    job.s = s;
+    job.count = n;
+    job.items = (BatchItem *)calloc(n ? n : 1, sizeof(BatchItem));
+    double *lat = (double *)malloc((n ? n : 1) * sizeof(double));
+    pthread_t *tids = (pthread_t *)malloc((size_t)threads * sizeof(pthread_t));
+    if (!job.items || !lat || !tids) {
+        printf("Memory allocation failed\n");
+        free(job.items);
+        free(lat);
+        free(tids);
+        free(ciphers);
+        for (size_t i = 0; i < npaths; i++) free(paths[i]);
+        free(paths);
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        BatchItem *it = &job.items[i];
+        if (stream) {
+            it->path = list;
+            it->record = (long)i;
+            if ((long)i == bad) {
+                it->status = CIPHER_INVALID;
+            } else {
+                it->status = CIPHER_OK;
+                memcpy(it->cipher, ciphers[i], FP_LEN);
+            }
+        } else {
+            it->path = paths[i];
+            it->record = -1;
+        }
+    }
+    free(ciphers);
+    atomic_init(&job.next, 0);
+    mask_match_init();
+    cipher_reader_init();
+
+    double t0 = now_us();
+    int started = 0;
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, batch_worker, &job) != 0) break;
+        started++;
+    }
+    batch_worker(&job);
+    for (int t = 1; t <= started; t++) pthread_join(tids[t], NULL);
+    double wall = now_us() - t0;
+
+    /* results in input order */
+    fflush(stdout);
+    STAT_TIMER_START(STAT_FORMAT);
+    OutBuf out;
+    if (outbuf_init_fd(&out, 1)) {
+        char line[SOLUTION_LINE_MAX];
+        for (size_t i = 0; i < n; i++) {
+            const BatchItem *it = &job.items[i];
+            const Solution *sol = &it->sol;
+            if (it->status == CIPHER_OPEN_ERROR) {
+                snprintf(line, sizeof(line), "Error opening file: %s\n", it->path);
+            } else if (it->status == CIPHER_INVALID && it->record >= 0) {
+                snprintf(line, sizeof(line), "Invalid cipher record %ld in %s\n", it->record, it->path);
+            } else if (it->status == CIPHER_INVALID) {
+                snprintf(line, sizeof(line), "Invalid cipher file: %s\n", it->path);
+            } else {
+                format_solution(line, sizeof(line), org, sol);
+            }
+            outbuf_puts(&out, line);
+            lat[i] = it->latency_us;
+        }
+        outbuf_close(&out);
+    }
+    STAT_TIMER_STOP(STAT_FORMAT);
+
+    qsort(lat, n, sizeof(double), cmp_double);
+    double p50 = n ? lat[n / 2] : 0, p99 = n ? lat[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1] : 0;
+    double max = n ? lat[n - 1] : 0;
+    fprintf(stderr, "batch: %zu ciphers, %d threads, %.3f s, %.0f ciphers/s\n",
+            n, started + 1, wall / 1e6, wall > 0 ? (double)n / (wall / 1e6) : 0.0);
+    fprintf(stderr, "latency us: p50 %.1f  p99 %.1f  max %.1f\n", p50, p99, max);
+
+    free(job.items);
+    free(lat);
+    free(tids);
+    for (size_t i = 0; i < npaths; i++) free(paths[i]);
+    free(paths);
+    return 1;
 }
 
 int main(int argc, char **argv) {
-    if (argc != 4) {
-        printf("Usage: %s <clean_file.txt> <cipher_bits.txt> <mask_start_s>\n", argv[0]);
+    /* --stats anywhere: per-stage breakdown on stderr at exit (needs a HW_STATS build) */
+    stats_take_flag(&argc, argv, "ex2");
+    if (argc == 4 && strcmp(argv[1], "--snapshot") == 0) {
+        OrgFlat org;
+        if (load_org(argv[2], &org, NULL)) save_org_snapshot(&org, argv[3]);
+        org_flat_free(&org);
+        return 0;
+    }
+    if (argc == 4 && strcmp(argv[1], "--pack") == 0) {
+        /* any cipher file or stream to the packed binary format */
+        uint8_t (*ciphers)[CIPHER_LEN];
+        size_t n;
+        long bad;
+        if (read_cipher_stream(argv[2], CIPHER_FMT_AUTO, &ciphers, &n, &bad)) {
+            if (bad >= 0) printf("Invalid cipher record %ld in %s\n", bad, argv[2]);
+            else cipher_write_binary(argv[3], (const uint8_t (*)[CIPHER_LEN])ciphers, n);
+        }
+        free(ciphers);
         return 0;
     }
 
-    uint8_t cipher[FP_LEN];
-    if (!read_cipher_bits(argv[2], cipher)) {
-        /* Error already printed if file couldn't open; otherwise just exit gracefully */
+    /* --solve: one analytic pass instead of the mask loop; --full-range: search masks 0..255
+     * --batch: the cipher argument lists many ciphers; -j N: worker threads
+     * --stream: batch over the records of one multi-cipher file; --format F: cipher file format
+     * --key-width W, --ops a,b,..., --range lo:hi: search with the key engine */
+    const char *prog = argv[0];
+    SearchMode mode;
+    memset(&mode, 0, sizeof(mode));
+    mode.keys.width = 1;
+    int batch = 0, stream = 0, threads = 1, have_range = 0, bad = 0;
+    CipherFormat fmt = CIPHER_FMT_AUTO;
+    long long range_lo = 0, range_hi = 0;
+    while (argc > 1 && argv[1][0] == '-' && argv[1][1] != '\0') {
+        const char *opt = argv[1];
+        const char *val = argc > 2 ? argv[2] : NULL;
+        int used = 1;   /* argv entries taken by this option */
+        if (strcmp(opt, "--solve") == 0) mode.solve = 1;
+        else if (strcmp(opt, "--full-range") == 0) mode.solve = mode.full_range = 1;
+        else if (strcmp(opt, "--batch") == 0) batch = 1;
+        else if (strcmp(opt, "--stream") == 0) batch = stream = 1;
+        else if (!val) break;
+        else if (strcmp(opt, "--format") == 0) {
+            if (!cipher_format_parse(val, &fmt)) bad = 1;
+            used = 2;
+        }
+        else if (strcmp(opt, "-j") == 0) {
+            threads = atoi(val);
+            used = 2;
+        } else if (strcmp(opt, "--key-width") == 0) {
+            mode.keys.width = atoi(val);
+            if (mode.keys.width < 1 || mode.keys.width > KEY_MAX_WIDTH) bad = 1;
+            mode.extended = 1;
+            used = 2;
+        } else if (strcmp(opt, "--ops") == 0) {
+            mode.keys.op_count = key_ops_parse(val, mode.keys.ops);
+            if (mode.keys.op_count == 0) bad = 1;
+            mode.extended = 1;
+            used = 2;
+        } else if (strcmp(opt, "--range") == 0) {
+            if (sscanf(val, "%lld:%lld", &range_lo, &range_hi) != 2 || range_hi < range_lo) bad = 1;
+            have_range = mode.extended = 1;
+            used = 2;
+        } else break;
+        argv += used;
+        argc -= used;
+    }
+
+    if (argc != 4 || threads < 1 || bad) {
+        printf("Usage: %s [--solve] [--full-range] [--format auto|bits|hex|binary] <clean_file.txt|org.snap> <cipher_file> <mask_start_s>\n", prog);
+        printf("       %s --batch [-j threads] [--solve] [--full-range] <clean_file.txt|org.snap> <manifest|dir|-> <mask_start_s>\n", prog);
+        printf("       %s --stream [-j threads] [--solve] [--full-range] <clean_file.txt|org.snap> <cipher_stream|-> <mask_start_s>\n", prog);
+        printf("       %s [--key-width 1-%d] [--ops xor,and,or,add,rol] [--range lo:hi] [-j threads] <clean_file.txt|org.snap> <cipher_bits.txt> <mask_start_s>\n",
+               prog, KEY_MAX_WIDTH);
+        printf("       %s --snapshot <clean_file.txt> <org.snap>\n", prog);
+        printf("       %s --pack <cipher_file> <ciphers.bin>\n", prog);
+        printf("       --stats with any of these: per-stage breakdown on stderr (HW_STATS builds)\n");
         return 0;
     }
 
     int s = atoi(argv[3]);
+    if (mode.extended) {
+        /* defaults: XOR then AND, masks s..s+10 for one byte keys, s..max for wider ones */
+        if (mode.keys.op_count == 0) {
+            mode.keys.ops[0] = key_op_find("xor");
+            mode.keys.ops[1] = key_op_find("and");
+            mode.keys.op_count = 2;
+        }
+        if (have_range) {
+            mode.keys.lo = range_lo;
+            mode.keys.hi = range_hi;
+        } else {
+            mode.keys.lo = s;
+            mode.keys.hi = mode.keys.width == 1 ? (int64_t)s + 10 : ((int64_t)1 << (8 * mode.keys.width)) - 1;
+            if (mode.keys.hi < mode.keys.lo) mode.keys.hi = mode.keys.lo;
+        }
+        /* batch mode already runs one cipher per thread */
+        mode.keys.threads = batch ? 1 : threads;
+    }
+    OrgFlat org;
+    OrgIndex ix;
+    /* only the mask window search probes the index */
+    OrgIndex *want_ix = (mode.solve || mode.extended) ? NULL : &ix;
+    memset(&ix, 0, sizeof(ix));
 
-    Org org = build_org_from_clean_file(argv[1]);
-    if (!org.boss) {
-        /* build_org_from_clean_file prints file error if any */
-        free_org(&org);
+    if (batch) {
+        if (load_org(argv[1], &org, want_ix)) run_batch(&org, &ix, argv[2], stream, fmt, s, &mode, threads);
+        org_index_free(&ix);
+        org_flat_free(&org);
         return 0;
     }
 
-    for (int mask = s; mask <= s + 10; mask++) {
-        Node *n_xor = find_match_in_org(&org, cipher, mask, 1);
-        if (n_xor) {
-            print_success(mask, "XOR", n_xor->fingerprint, n_xor->first, n_xor->second);
-            free_org(&org);
-            return 0;
-        }
+    uint8_t cipher[FP_LEN];
+    if (!read_cipher(argv[2], fmt, cipher)) {
+        /* Error already printed if file couldn't open; otherwise just exit gracefully */
+        return 0;
+    }
 
-        Node *n_and = find_match_in_org(&org, cipher, mask, 0);
-        if (n_and) {
-            print_success(mask, "AND", n_and->fingerprint, n_and->first, n_and->second);
-            free_org(&org);
-            return 0;
-        }
+    if (!load_org(argv[1], &org, want_ix)) {
+        org_index_free(&ix);
+        org_flat_free(&org);
+        return 0;
     }
 
-    print_unsuccess();
-    free_org(&org);
+    Solution sol = decrypt(&org, &ix, cipher, s, &mode);
+    STAT_TIMER_START(STAT_FORMAT);
+    report_result(&org, &sol);
+    STAT_TIMER_STOP(STAT_FORMAT);
+    org_index_free(&ix);
+    org_flat_free(&org);
     return 0;
 }
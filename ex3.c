@@ -1,13 +1,240 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "fixed_point.h"
+#include "poly_lut.h"
+#include "io_buf.h"
+#include "stats.h"
+
+#define STREAM_CHUNK 65536
+
+static const char *stream_path(const char *path) {
+    return strcmp(path, "-") == 0 ? "/dev/stdin" : path;
+}
+
+/* Raw int16 samples in, raw int16 outputs out (host byte order), or with
+ * decimal set the outputs as print_fixed() text, one per line, formatted a
+ * chunk at a time into one buffer. */
+static int stream_binary(const PolyLut *lut, InputReader *in, OutBuf *out, int decimal) {
+    static char text[(STREAM_CHUNK / 2 + 1) * FIXED_DEC_MAX];
+    int16_t x[STREAM_CHUNK / 2 + 1];
+    int16_t y[STREAM_CHUNK / 2 + 1];
+    uint8_t carry = 0;
+    int have_carry = 0;
+    const char *data;
+    size_t n;
+    while (1) {
+        STAT_TIMER_START(STAT_READ);
+        n = reader_next(in, &data);
+        STAT_TIMER_STOP(STAT_READ);
+        if (n == 0) break;
+        uint8_t *dst = (uint8_t *)x;
+        size_t len = 0;
+        if (have_carry) {
+            dst[len++] = carry;
+            have_carry = 0;
+        }
+        memcpy(dst + len, data, n);
+        len += n;
+        if (len & 1) {
+            carry = dst[--len];
+            have_carry = 1;
+        }
+        STAT_TIMER_START(STAT_POLY_EVAL);
+        poly_lut_map(lut, x, y, len / 2);
+        STAT_TIMER_STOP(STAT_POLY_EVAL);
+        STAT_COUNT(STAT_SAMPLES, len / 2);
+        const char *bytes = (const char *)y;
+        if (decimal) {
+            STAT_TIMER_START(STAT_FORMAT);
+            len = format_fixed_lines(text, y, len / 2, lut->q);
+            bytes = text;
+            STAT_TIMER_STOP(STAT_FORMAT);
+        }
+        STAT_TIMER_START(STAT_WRITE);
+        outbuf_put(out, bytes, len);
+        STAT_TIMER_STOP(STAT_WRITE);
+    }
+    /* stdout may be carrying the samples, so notices go to stderr */
+    if (have_carry) fprintf(stderr, "Ignoring a trailing odd byte\n");
+    return 1;
+}
+
+/* Decimal digits of v into p; returns the length. */
+static size_t format_int16(char *p, int16_t v) {
+    char tmp[8];
+    size_t n = 0, len = 0;
+    unsigned u = v < 0 ? (unsigned)(-(int)v) : (unsigned)v;
+    do {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) p[len++] = '-';
+    while (n) p[len++] = tmp[--n];
+    return len;
+}
+
+static int is_space(char ch) {
+    return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f';
+}
+
+/* Whitespace separated integers in, one output per line out (raw, or as
+ * print_fixed() text with decimal set). Each token is read like atoi() and
+ * cast to int16_t like the single-value mode: sign and leading digits count,
+ * the value wraps modulo 2^16, anything else ends it. */
+static int stream_text(const PolyLut *lut, InputReader *in, OutBuf *out, int decimal) {
+    static char line[STREAM_CHUNK * 4];
+    char token[64];
+    size_t token_len = 0;
+    size_t at = 0;
+    const char *data;
+    size_t n;
+    int more = 1;
+    while (more) {
+        STAT_TIMER_START(STAT_READ);
+        n = reader_next(in, &data);
+        STAT_TIMER_STOP(STAT_READ);
+        more = n > 0;
+        /* tokens, lookups and output text all count as formatting here */
+        STAT_TIMER_START(STAT_FORMAT);
+        for (size_t i = 0; i <= n; i++) {
+            /* end of input acts as one more separator */
+            int sep = i == n ? !more : is_space(data[i]);
+            if (i == n && more) break;
+            if (!sep) {
+                if (token_len < sizeof(token)) token[token_len++] = data[i];
+                continue;
+            }
+            if (token_len == 0) continue;
+
+            size_t k = 0;
+            int neg = 0;
+            if (token[k] == '+' || token[k] == '-') neg = token[k++] == '-';
+            uint16_t v = 0;
+            while (k < token_len && token[k] >= '0' && token[k] <= '9') v = (uint16_t)(v * 10u + (unsigned)(token[k++] - '0'));
+            if (neg) v = (uint16_t)(0u - v);
+            token_len = 0;
+
+            int16_t y = poly_lut_eval(lut, (int16_t)v);
+            STAT_COUNT(STAT_SAMPLES, 1);
+            at += decimal ? format_fixed(line + at, y, lut->q) : format_int16(line + at, y);
+            line[at++] = '\n';
+            if (at > sizeof(line) - FIXED_DEC_MAX - 1) {
+                outbuf_put(out, line, at);
+                at = 0;
+            }
+        }
+        STAT_TIMER_STOP(STAT_FORMAT);
+    }
+    outbuf_put(out, line, at);
+    return 1;
+}
+
+/* ex3 --stream [--binary] [--decimal] [-j threads] [--lut table.lut | a b c q] <in|-> <out|->
+ * ex3 --save-lut [-j threads] a b c q <table.lut> */
+static int run_table_mode(int argc, char **argv) {
+    const char *prog = argv[0];
+    int save = strcmp(argv[1], "--save-lut") == 0;
+    int binary = 0, decimal = 0, threads = 1;
+    const char *lut_path = NULL;
+    argv += 2;
+    argc -= 2;
+    while (argc > 0 && argv[0][0] == '-' && argv[0][1] == '-') {
+        if (!save && strcmp(argv[0], "--binary") == 0) {
+            binary = 1;
+            argv++;
+            argc--;
+        } else if (!save && strcmp(argv[0], "--decimal") == 0) {
+            decimal = 1;
+            argv++;
+            argc--;
+        } else if (!save && strcmp(argv[0], "--lut") == 0 && argc > 1) {
+            lut_path = argv[1];
+            argv += 2;
+            argc -= 2;
+        } else break;
+    }
+    if (argc > 1 && strcmp(argv[0], "-j") == 0) {
+        threads = atoi(argv[1]);
+        argv += 2;
+        argc -= 2;
+    }
+
+    int want = save ? 5 : lut_path ? 2 : 6;
+    if (argc != want || threads < 1) {
+        printf("Usage: %s --stream [--binary] [--decimal] [-j threads] <a_raw> <b_raw> <c_raw> <q> <x_file|-> <out_file|->\n", prog);
+        printf("       %s --stream [--binary] [--decimal] --lut <table.lut> <x_file|-> <out_file|->\n", prog);
+        printf("       %s --save-lut [-j threads] <a_raw> <b_raw> <c_raw> <q> <table.lut>\n", prog);
+        return 0;
+    }
+
+    PolyLut lut;
+    if (lut_path) {
+        STAT_TIMER_START(STAT_READ);
+        int rc = poly_lut_load(lut_path, &lut);
+        STAT_TIMER_STOP(STAT_READ);
+        if (rc == 0) printf("Not a table file: %s\n", lut_path);
+        if (rc <= 0) return 0;
+    } else {
+        STAT_TIMER_START(STAT_POLY_EVAL);
+        int built = poly_lut_build(&lut, (int16_t)atoi(argv[0]), (int16_t)atoi(argv[1]), (int16_t)atoi(argv[2]),
+                                   (int16_t)atoi(argv[3]), threads);
+        STAT_TIMER_STOP(STAT_POLY_EVAL);
+        if (!built) {
+            printf("Memory allocation failed\n");
+            return 0;
+        }
+    }
+    if (save) {
+        STAT_TIMER_START(STAT_WRITE);
+        poly_lut_save(&lut, argv[4]);
+        STAT_TIMER_STOP(STAT_WRITE);
+        poly_lut_free(&lut);
+        return 0;
+    }
+
+    const char *in_path = argv[argc - 2];
+    const char *out_path = argv[argc - 1];
+    InputReader in;
+    if (!reader_open(&in, stream_path(in_path), STREAM_CHUNK)) {
+        printf("Error opening file: %s\n", in_path);
+        poly_lut_free(&lut);
+        return 0;
+    }
+    OutBuf out;
+    int ok = strcmp(out_path, "-") == 0 ? outbuf_init_fd(&out, 1) : outbuf_open(&out, out_path);
+    if (!ok) {
+        printf("Error opening file: %s\n", out_path);
+        reader_close(&in);
+        poly_lut_free(&lut);
+        return 0;
+    }
+
+    if (binary) stream_binary(&lut, &in, &out, decimal);
+    else stream_text(&lut, &in, &out, decimal);
+    STAT_TIMER_START(STAT_WRITE);
+    ok = outbuf_close(&out);
+    STAT_TIMER_STOP(STAT_WRITE);
+    if (!ok) fprintf(stderr, "Error writing file: %s\n", out_path);
+    reader_close(&in);
+    poly_lut_free(&lut);
+    return 0;
+}
 
 int main(int argc, char **argv) {
+    /* --stats anywhere: per-stage breakdown on stderr at exit (needs a HW_STATS build) */
+    stats_take_flag(&argc, argv, "ex3");
+    if (argc > 1 && (strcmp(argv[1], "--stream") == 0 || strcmp(argv[1], "--save-lut") == 0)) {
+        return run_table_mode(argc, argv);
+    }
+
     if (argc != 6) {
         printf("Usage: %s <x_raw> <a_raw> <b_raw> <c_raw> <q>\n", argv[0]);
         printf("All inputs must be integers. (x/a/b/c/q are int16 raw fixed-point values)\n");
+        printf("       %s --stream | --save-lut ...  (table modes, give just the flag for their usage)\n", argv[0]);
+        printf("       --stats with any of these: per-stage breakdown on stderr (HW_STATS builds)\n");
         return 0;
     }
 
@@ -17,6 +244,9 @@ int main(int argc, char **argv) {
     int16_t c = (int16_t)atoi(argv[4]);
     int16_t q = (int16_t)atoi(argv[5]);
 
+    STAT_TIMER_START(STAT_POLY_EVAL);
     eval_poly_ax2_minus_bx_plus_c_fixed(x, a, b, c, q);
+    STAT_TIMER_STOP(STAT_POLY_EVAL);
+    STAT_COUNT(STAT_SAMPLES, 1);
     return 0;
 }
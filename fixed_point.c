@@ -1,56 +1,236 @@
 #include "fixed_point.h"
+#include "fixed_q.h"
 #include <stdio.h>
 #include <stdint.h>
-#include <inttypes.h>
+#include <string.h>
 
-void print_fixed(int16_t raw, int16_t q) {
-    /* Print raw / 2^q with exactly 6 decimals, truncating toward zero. */
-    int64_t denom = (int64_t)1 << q;
-    int64_t scaled = (int64_t)raw * 1000000LL;
-    int64_t scaled_val = scaled / denom; /* truncates toward zero */
-
-    if (scaled_val < 0) {
-        putchar('-');
-        scaled_val = -scaled_val;
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIXED_POINT_X86 1
+#endif
+
+/* "00" "01" ... "99": two digits per lookup. */
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Decimal v (< 100000) at p without leading zeros; returns the length. */
+static size_t put_uint(char *p, uint32_t v) {
+    size_t len = v >= 10000 ? 5 : v >= 1000 ? 4 : v >= 100 ? 3 : v >= 10 ? 2 : 1;
+    char *end = p + len;
+    while (v >= 100) {
+        end -= 2;
+        memcpy(end, digit_pairs + 2 * (v % 100), 2);
+        v /= 100;
     }
+    if (v >= 10) memcpy(end - 2, digit_pairs + 2 * v, 2);
+    else end[-1] = (char)('0' + v);
+    return len;
+}
 
-    int64_t int_part = scaled_val / 1000000LL;
-    int64_t frac_part = scaled_val % 1000000LL;
+size_t format_fixed(char *buf, int16_t raw, int16_t q) {
+    /* raw / 2^q with exactly 6 decimals, truncating toward zero: |raw| * 10^6
+     * stays below 2^36, so shifting the magnitude right by q is the
+     * truncating division and the sign is put back in front when anything
+     * is left of it */
+    uint64_t mag = (uint64_t)(raw < 0 ? -(int32_t)raw : raw) * 1000000u;
+    mag = (unsigned)q <= 62 ? mag >> q : 0;
 
-    printf("%" PRId64 ".%06" PRId64, int_part, frac_part);
+    char *p = buf;
+    if (raw < 0 && mag) *p++ = '-';
+    uint32_t int_part = (uint32_t)(mag / 1000000u);
+    uint32_t frac_part = (uint32_t)(mag % 1000000u);
+    p += put_uint(p, int_part);
+    *p++ = '.';
+    memcpy(p, digit_pairs + 2 * (frac_part / 10000), 2);
+    memcpy(p + 2, digit_pairs + 2 * (frac_part / 100 % 100), 2);
+    memcpy(p + 4, digit_pairs + 2 * (frac_part % 100), 2);
+    return (size_t)(p + 6 - buf);
+}
+
+size_t format_fixed_lines(char *buf, const int16_t *raw, size_t n, int16_t q) {
+    char *p = buf;
+    for (size_t i = 0; i < n; i++) {
+        p += format_fixed(p, raw[i], q);
+        *p++ = '\n';
+    }
+    return (size_t)(p - buf);
+}
+
+void print_fixed(int16_t raw, int16_t q) {
+    char buf[FIXED_DEC_MAX];
+    fwrite(buf, 1, format_fixed(buf, raw, q), stdout);
 }
 
 int16_t add_fixed(int16_t a, int16_t b) {
-    return (int16_t)(a + b);
+    return fx16_add(a, b);
 }
 
 int16_t subtract_fixed(int16_t a, int16_t b) {
-    return (int16_t)(a - b);
+    return fx16_sub(a, b);
 }
 
 int16_t multiply_fixed(int16_t a, int16_t b, int16_t q) {
     /* raw_out = (raw_a * raw_b) / 2^q  (truncate toward zero) */
-    int64_t prod = (int64_t)a * (int64_t)b;
-    int64_t denom = (int64_t)1 << q;
-    int64_t out = prod / denom;
-    return (int16_t)out;
+    return fx16_mul(a, b, q);
+}
+
+static int16_t eval_poly_fixed(int16_t x, int16_t a, int16_t b, int16_t c, int16_t q) {
+    /* y = a*x^2 - b*x + c, each step wrapped to int16 in this order; Horner
+     * ((a*x - b)*x + c) truncates at different points and would change the
+     * printed results */
+    int16_t x2 = fx16_mul(x, x, q);
+    int16_t ax2 = fx16_mul(a, x2, q);
+    int16_t bx = fx16_mul(b, x, q);
+    return fx16_add(fx16_sub(ax2, bx), c);
+}
+
+static size_t put_str(char *p, const char *s, size_t len) {
+    memcpy(p, s, len);
+    return len;
+}
+
+size_t format_poly_result(char *buf, int16_t y, int16_t a, int16_t b, int16_t c, int16_t q) {
+    static const char head[] = "the polynomial output for a=";
+    char *p = buf;
+    p += put_str(p, head, sizeof(head) - 1);
+    p += format_fixed(p, a, q);
+    p += put_str(p, ", b=", 4);
+    p += format_fixed(p, b, q);
+    p += put_str(p, ", c=", 4);
+    p += format_fixed(p, c, q);
+    p += put_str(p, " is ", 4);
+    p += format_fixed(p, y, q);
+    *p++ = '\n';
+    return (size_t)(p - buf);
 }
 
 void eval_poly_ax2_minus_bx_plus_c_fixed(int16_t x, int16_t a, int16_t b, int16_t c, int16_t q) {
-    /* y = a*x^2 - b*x + c */
-    int16_t x2 = multiply_fixed(x, x, q);
-    int16_t ax2 = multiply_fixed(a, x2, q);
-    int16_t bx = multiply_fixed(b, x, q);
-    int16_t ax2_minus_bx = subtract_fixed(ax2, bx);
-    int16_t y = add_fixed(ax2_minus_bx, c);
-
-    printf("the polynomial output for a=");
-    print_fixed(a, q);
-    printf(", b=");
-    print_fixed(b, q);
-    printf(", c=");
-    print_fixed(c, q);
-    printf(" is ");
-    print_fixed(y, q);
-    printf("\n");
+    char line[FIXED_POLY_LINE_MAX];
+    size_t len = format_poly_result(line, eval_poly_fixed(x, a, b, c, q), a, b, c, q);
+    fwrite(line, 1, len, stdout);
+}
+
+/* ---- Batch evaluation ----
+ * The product of two int16 values fits in 32 bits, so the vector kernels
+ * multiply 16-bit lanes (mullo / mulhi halves interleaved into 32-bit
+ * products), divide by 2^q with an arithmetic shift after adding 2^q - 1 to
+ * negative products (truncation toward zero, like the int64 division), and
+ * keep the low 16 bits of the quotient like the (int16_t) cast. */
+typedef void (*PolyKernel)(const int16_t *x, int16_t *y, size_t n,
+                           int16_t a, int16_t b, int16_t c, int16_t q);
+
+static PolyKernel poly_kernel = NULL;
+static const char *poly_kernel_name = "scalar";
+
+void eval_poly_fixed_batch_scalar(const int16_t *x, int16_t *y, size_t n,
+                                  int16_t a, int16_t b, int16_t c, int16_t q) {
+    for (size_t i = 0; i < n; i++) y[i] = eval_poly_fixed(x[i], a, b, c, q);
+}
+
+#ifdef FIXED_POINT_X86
+
+/* (u * v) / 2^q truncated toward zero, wrapped to int16, in every lane. */
+__attribute__((target("sse2")))
+static __m128i mul_fixed_sse2(__m128i u, __m128i v, __m128i shift, __m128i round) {
+    __m128i lo = _mm_mullo_epi16(u, v);
+    __m128i hi = _mm_mulhi_epi16(u, v);
+    __m128i p0 = _mm_unpacklo_epi16(lo, hi);
+    __m128i p1 = _mm_unpackhi_epi16(lo, hi);
+    p0 = _mm_sra_epi32(_mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), round)), shift);
+    p1 = _mm_sra_epi32(_mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), round)), shift);
+    /* sign-extend the low halves so the saturating pack only ever wraps */
+    p0 = _mm_srai_epi32(_mm_slli_epi32(p0, 16), 16);
+    p1 = _mm_srai_epi32(_mm_slli_epi32(p1, 16), 16);
+    return _mm_packs_epi32(p0, p1);
+}
+
+__attribute__((target("sse2")))
+static void eval_poly_sse2(const int16_t *x, int16_t *y, size_t n,
+                           int16_t a, int16_t b, int16_t c, int16_t q) {
+    const __m128i va = _mm_set1_epi16(a);
+    const __m128i vb = _mm_set1_epi16(b);
+    const __m128i vc = _mm_set1_epi16(c);
+    const __m128i shift = _mm_cvtsi32_si128(q);
+    const __m128i round = _mm_set1_epi32((1 << q) - 1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i vx = _mm_loadu_si128((const __m128i *)(x + i));
+        __m128i x2 = mul_fixed_sse2(vx, vx, shift, round);
+        __m128i ax2 = mul_fixed_sse2(va, x2, shift, round);
+        __m128i bx = mul_fixed_sse2(vb, vx, shift, round);
+        _mm_storeu_si128((__m128i *)(y + i), _mm_add_epi16(_mm_sub_epi16(ax2, bx), vc));
+    }
+    eval_poly_fixed_batch_scalar(x + i, y + i, n - i, a, b, c, q);
+}
+
+/* Same as mul_fixed_sse2 on 16 lanes; unpack and pack both work within
+ * 128-bit halves, so the lane order comes back unchanged. */
+__attribute__((target("avx2")))
+static __m256i mul_fixed_avx2(__m256i u, __m256i v, __m128i shift, __m256i round) {
+    __m256i lo = _mm256_mullo_epi16(u, v);
+    __m256i hi = _mm256_mulhi_epi16(u, v);
+    __m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+    __m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+    p0 = _mm256_sra_epi32(_mm256_add_epi32(p0, _mm256_and_si256(_mm256_srai_epi32(p0, 31), round)), shift);
+    p1 = _mm256_sra_epi32(_mm256_add_epi32(p1, _mm256_and_si256(_mm256_srai_epi32(p1, 31), round)), shift);
+    p0 = _mm256_srai_epi32(_mm256_slli_epi32(p0, 16), 16);
+    p1 = _mm256_srai_epi32(_mm256_slli_epi32(p1, 16), 16);
+    return _mm256_packs_epi32(p0, p1);
+}
+
+__attribute__((target("avx2")))
+static void eval_poly_avx2(const int16_t *x, int16_t *y, size_t n,
+                           int16_t a, int16_t b, int16_t c, int16_t q) {
+    const __m256i va = _mm256_set1_epi16(a);
+    const __m256i vb = _mm256_set1_epi16(b);
+    const __m256i vc = _mm256_set1_epi16(c);
+    const __m128i shift = _mm_cvtsi32_si128(q);
+    const __m256i round = _mm256_set1_epi32((1 << q) - 1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i vx = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i x2 = mul_fixed_avx2(vx, vx, shift, round);
+        __m256i ax2 = mul_fixed_avx2(va, x2, shift, round);
+        __m256i bx = mul_fixed_avx2(vb, vx, shift, round);
+        _mm256_storeu_si256((__m256i *)(y + i), _mm256_add_epi16(_mm256_sub_epi16(ax2, bx), vc));
+    }
+    eval_poly_fixed_batch_scalar(x + i, y + i, n - i, a, b, c, q);
+}
+
+#endif
+
+void eval_poly_fixed_init(void) {
+    if (poly_kernel) return;
+#ifdef FIXED_POINT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        poly_kernel_name = "avx2";
+        poly_kernel = eval_poly_avx2;
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        poly_kernel_name = "sse2";
+        poly_kernel = eval_poly_sse2;
+        return;
+    }
+#endif
+    poly_kernel_name = "scalar";
+    poly_kernel = eval_poly_fixed_batch_scalar;
+}
+
+void eval_poly_fixed_batch(const int16_t *x, int16_t *y, size_t n,
+                           int16_t a, int16_t b, int16_t c, int16_t q) {
+    if (!poly_kernel) eval_poly_fixed_init();
+    if (q < 0 || q > 30) {
+        eval_poly_fixed_batch_scalar(x, y, n, a, b, c, q);
+        return;
+    }
+    poly_kernel(x, y, n, a, b, c, q);
+}
+
+const char *eval_poly_fixed_kernel_name(void) {
+    eval_poly_fixed_init();
+    return poly_kernel_name;
 }
@@ -1,11 +1,24 @@
 #ifndef FIXED_POINT_H
 #define FIXED_POINT_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* Prints a fixed-point number (raw) in decimal, using q fractional bits. */
 void    print_fixed(int16_t raw, int16_t q);
 
+/* Longest format_fixed() output ("-32768.000000" is 13 bytes), rounded up. */
+#define FIXED_DEC_MAX 16
+
+/* Writes what print_fixed() prints into buf (at least FIXED_DEC_MAX bytes,
+ * not NUL-terminated) and returns its length: raw / 2^q with 6 decimals,
+ * truncated toward zero. q outside 0..62 formats as 0.000000. */
+size_t  format_fixed(char *buf, int16_t raw, int16_t q);
+
+/* format_fixed() of every raw[i], one per line, into buf (at least
+ * n * FIXED_DEC_MAX bytes). Returns the total length. */
+size_t  format_fixed_lines(char *buf, const int16_t *raw, size_t n, int16_t q);
+
 /* Fixed-point addition (same q for both inputs). */
 int16_t add_fixed(int16_t a, int16_t b);
 
@@ -15,6 +28,14 @@ int16_t subtract_fixed(int16_t a, int16_t b);
 /* Fixed-point multiplication (a*b)>>q (same q for both inputs). */
 int16_t multiply_fixed(int16_t a, int16_t b, int16_t q);
 
+/* Longest format_poly_result() line, rounded up. */
+#define FIXED_POLY_LINE_MAX 128
+
+/* The message eval_poly_ax2_minus_bx_plus_c_fixed() prints for result y,
+ * newline included, into buf (at least FIXED_POLY_LINE_MAX bytes). Returns
+ * its length. */
+size_t format_poly_result(char *buf, int16_t y, int16_t a, int16_t b, int16_t c, int16_t q);
+
 /* Evaluate y = a*x^2 - b*x + c in fixed-point and print the required message. */
 void eval_poly_ax2_minus_bx_plus_c_fixed(int16_t x,
                                             int16_t a,
@@ -22,4 +43,23 @@ void eval_poly_ax2_minus_bx_plus_c_fixed(int16_t x,
                                             int16_t c,
                                             int16_t q);
 
+/* Picks the fastest batch kernel for this CPU. Called implicitly by
+ * eval_poly_fixed_batch(), call it up front when several threads will
+ * evaluate concurrently. */
+void eval_poly_fixed_init(void);
+
+/* y[i] = a*x[i]^2 - b*x[i] + c for i < n, computed exactly like
+ * eval_poly_ax2_minus_bx_plus_c_fixed (every product truncated toward zero,
+ * every step wrapped to int16) but without printing. x and y may be the
+ * same array. Vector kernels cover q in 0..30, other q use the scalar loop. */
+void eval_poly_fixed_batch(const int16_t *x, int16_t *y, size_t n,
+                           int16_t a, int16_t b, int16_t c, int16_t q);
+
+/* Reference one-sample-at-a-time implementation. */
+void eval_poly_fixed_batch_scalar(const int16_t *x, int16_t *y, size_t n,
+                                  int16_t a, int16_t b, int16_t c, int16_t q);
+
+/* Name of the kernel eval_poly_fixed_batch() dispatches to ("avx2", "sse2", "scalar"). */
+const char *eval_poly_fixed_kernel_name(void);
+
 #endif // FIXED_POINT_H
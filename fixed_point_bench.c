@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fixed_point.h"
+
+/* Throughput of eval_poly_fixed_batch against the one-sample-at-a-time loop
+ * over the same samples, and of format_fixed_lines against the printf-style
+ * formatting it replaced; also checks that both sides give the same output. */
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+typedef void (*BatchFn)(const int16_t *x, int16_t *y, size_t n,
+                        int16_t a, int16_t b, int16_t c, int16_t q);
+
+/* Best of reps runs, in samples per second. */
+static double measure(BatchFn fn, const int16_t *x, int16_t *y, size_t n,
+                      int16_t a, int16_t b, int16_t c, int16_t q, int reps) {
+    double best = 0;
+    for (int r = 0; r < reps; r++) {
+        double t0 = now_s();
+        fn(x, y, n, a, b, c, q);
+        double t = now_s() - t0;
+        if (t > 0 && (double)n / t > best) best = (double)n / t;
+    }
+    return best;
+}
+
+/* The print_fixed() format as it was written with printf, one per line. */
+static size_t format_lines_printf(char *buf, const int16_t *raw, size_t n, int16_t q) {
+    char *p = buf;
+    for (size_t i = 0; i < n; i++) {
+        int64_t scaled_val = (int64_t)raw[i] * INT64_C(1000000) / ((int64_t)1 << q);
+        if (scaled_val < 0) {
+            *p++ = '-';
+            scaled_val = -scaled_val;
+        }
+        p += sprintf(p, "%" PRId64 ".%06" PRId64 "\n", scaled_val / INT64_C(1000000), scaled_val % INT64_C(1000000));
+    }
+    return (size_t)(p - buf);
+}
+
+typedef size_t (*FormatFn)(char *buf, const int16_t *raw, size_t n, int16_t q);
+
+/* Best of reps runs, in values per second; *len gets the output length. */
+static double measure_format(FormatFn fn, char *buf, const int16_t *raw, size_t n, int16_t q,
+                             int reps, size_t *len) {
+    double best = 0;
+    for (int r = 0; r < reps; r++) {
+        double t0 = now_s();
+        *len = fn(buf, raw, n, q);
+        double t = now_s() - t0;
+        if (t > 0 && (double)n / t > best) best = (double)n / t;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 4u << 20;
+    int16_t q = argc > 2 ? (int16_t)atoi(argv[2]) : 8;
+    int reps = argc > 3 ? atoi(argv[3]) : 10;
+    if (n == 0 || reps < 1) {
+        printf("Usage: %s [samples] [q] [reps]\n", argv[0]);
+        return 0;
+    }
+
+    int16_t *x = (int16_t *)malloc(n * sizeof(int16_t));
+    int16_t *y_scalar = (int16_t *)malloc(n * sizeof(int16_t));
+    int16_t *y_batch = (int16_t *)malloc(n * sizeof(int16_t));
+    char *text_printf = (char *)malloc(n * FIXED_DEC_MAX);
+    char *text_fast = (char *)malloc(n * FIXED_DEC_MAX);
+    if (!x || !y_scalar || !y_batch || !text_printf || !text_fast) {
+        printf("Memory allocation failed\n");
+        free(x);
+        free(y_scalar);
+        free(y_batch);
+        free(text_printf);
+        free(text_fast);
+        return 0;
+    }
+    srand(12345);
+    for (size_t i = 0; i < n; i++) x[i] = (int16_t)(rand() & 0xFFFF);
+    const int16_t a = 301, b = -1207, c = 4099;
+
+    double scalar = measure(eval_poly_fixed_batch_scalar, x, y_scalar, n, a, b, c, q, reps);
+    double batch = measure(eval_poly_fixed_batch, x, y_batch, n, a, b, c, q, reps);
+    int same = memcmp(y_scalar, y_batch, n * sizeof(int16_t)) == 0;
+
+    /* the printf-style reference shifts by q directly, so keep q in range */
+    double fmt_printf = 0, fmt_fast = 0;
+    int same_text = 1;
+    if (q >= 0 && q <= 62) {
+        size_t len_printf, len_fast;
+        fmt_printf = measure_format(format_lines_printf, text_printf, y_batch, n, q, reps, &len_printf);
+        fmt_fast = measure_format(format_fixed_lines, text_fast, y_batch, n, q, reps, &len_fast);
+        same_text = len_printf == len_fast && memcmp(text_printf, text_fast, len_fast) == 0;
+    }
+
+    printf("samples %zu  q %d  kernel %s\n", n, q, eval_poly_fixed_kernel_name());
+    printf("scalar  %8.1f Msamples/s\n", scalar / 1e6);
+    printf("batch   %8.1f Msamples/s  (%.1fx)\n", batch / 1e6, scalar > 0 ? batch / scalar : 0.0);
+    printf("outputs %s\n", same ? "identical" : "DIFFER");
+    if (fmt_fast > 0) {
+        printf("format printf %8.1f Mvalues/s\n", fmt_printf / 1e6);
+        printf("format table  %8.1f Mvalues/s  (%.1fx)\n", fmt_fast / 1e6,
+               fmt_printf > 0 ? fmt_fast / fmt_printf : 0.0);
+        printf("text    %s\n", same_text ? "identical" : "DIFFER");
+    }
+
+    free(x);
+    free(y_scalar);
+    free(y_batch);
+    free(text_printf);
+    free(text_fast);
+    return same && same_text ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#ifndef FIXED_Q_H
+#define FIXED_Q_H
+
+#include <stdint.h>
+
+/* Fixed-point arithmetic on raw signed integers with q fractional bits.
+ *
+ * FIXQ_DEFINE_TYPE generates one storage width with q passed at run time:
+ *   fx8  (int8_t,  products in int32, Horner in int64)
+ *   fx16 (int16_t, products in int32, Horner in int64)
+ *   fx32 (int32_t, products in int64, Horner in __int128)
+ * Products always fit their type, so the plain operations are exact before
+ * the final wrap or clamp; Horner checks its accumulator (see below).
+ * FIXQ_DEFINE_Q pins q at compile time on top of one of them (q7, q8_8,
+ * q15, q16_16 below), so every shift is by a constant.
+ *
+ * Multiplication divides the exact product by 2^q truncating toward zero,
+ * as an arithmetic shift with 2^q - 1 added to negative values first.
+ * Plain results wrap to the storage type like a cast; the _sat variants
+ * clamp to its range instead. Valid q is 0 .. 2 * bits - 1; a larger (or
+ * negative) q divides every product down to 0. */
+
+__extension__ typedef __int128 fixq_i128;
+__extension__ typedef unsigned __int128 fixq_u128;
+
+/* v / 2^q truncated toward zero; 0 once 2^q exceeds every value. */
+static inline int32_t fixq_shr32(int32_t v, int q) {
+    if ((unsigned)q > 31) return 0;
+    return (v + ((v >> 31) & (int32_t)((UINT32_C(1) << q) - 1))) >> q;
+}
+
+static inline int64_t fixq_shr64(int64_t v, int q) {
+    if ((unsigned)q > 63) return 0;
+    return (v + ((v >> 63) & (int64_t)((UINT64_C(1) << q) - 1))) >> q;
+}
+
+static inline fixq_i128 fixq_shr128(fixq_i128 v, int q) {
+    if ((unsigned)q > 127) return 0;
+    fixq_i128 bias = (v < 0) ? (fixq_i128)(((fixq_u128)1 << q) - 1) : 0;
+    return (v + bias) >> q;
+}
+
+static inline int8_t fixq_sat8(int64_t v) {
+    return (int8_t)(v > INT8_MAX ? INT8_MAX : v < INT8_MIN ? INT8_MIN : v);
+}
+
+static inline int16_t fixq_sat16(int64_t v) {
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v);
+}
+
+static inline int32_t fixq_sat32(fixq_i128 v) {
+    return (int32_t)(v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : v);
+}
+
+/* T storage, W product type with its shift, H Horner accumulator with its
+ * shift, SAT clamp from H to T. P##_horner evaluates coef[0] + coef[1] x +
+ * ... + coef[degree] x^degree (degree >= 0) from the top coefficient down,
+ * one truncating multiply and one add per step, all in the accumulator;
+ * only the result is clamped (_horner_sat) or wrapped (_horner) to T.
+ *
+ * Every step checks the accumulator for overflow. It can only overflow
+ * once |x| > 2^q, and from there on it only grows and stays far outside T,
+ * so the exact result saturates with the sign it has after each later step
+ * (the product's; the coefficient is too small to change it). P##_horner_wide
+ * returns the exact value and 0, or on overflow that sign (1 or -1) with the
+ * value left unspecified. _horner_sat is exact for every input; _horner
+ * wraps any result that fits H and returns the saturated one otherwise,
+ * since wrapping it would need the exact digits H cannot hold. */
+#define FIXQ_DEFINE_TYPE(P, T, W, SHR, H, HSHR, SAT)                                   \
+    static inline T P##_add(T a, T b) { return (T)((H)a + b); }                        \
+    static inline T P##_sub(T a, T b) { return (T)((H)a - b); }                        \
+    static inline T P##_add_sat(T a, T b) { return SAT((H)a + b); }                    \
+    static inline T P##_sub_sat(T a, T b) { return SAT((H)a - b); }                    \
+    static inline T P##_mul(T a, T b, int q) { return (T)SHR((W)a * b, q); }           \
+    static inline T P##_mul_sat(T a, T b, int q) { return SAT(SHR((W)a * b, q)); }     \
+    static inline int P##_horner_wide(const T *coef, int degree, T x, int q, H *out) { \
+        H acc = coef[degree];                                                          \
+        int k = degree - 1;                                                            \
+        int sign = 0;                                                                  \
+        for (; k >= 0; k--) {                                                          \
+            H prod;                                                                    \
+            if (__builtin_mul_overflow(acc, (H)x, &prod)) {                            \
+                sign = (acc < 0) == (x < 0) ? 1 : -1;                                  \
+                break;                                                                 \
+            }                                                                          \
+            prod = HSHR(prod, q);                                                      \
+            if (__builtin_add_overflow(prod, (H)coef[k], &acc)) {                      \
+                sign = prod < 0 ? -1 : 1;                                              \
+                break;                                                                 \
+            }                                                                          \
+        }                                                                              \
+        /* past an overflow only the sign changes, with x's */                        \
+        for (k--; sign && k >= 0; k--) sign = x < 0 ? -sign : sign;                    \
+        *out = acc;                                                                    \
+        return sign;                                                                   \
+    }                                                                                  \
+    static inline T P##_horner_sat(const T *coef, int degree, T x, int q) {            \
+        H acc;                                                                         \
+        int sign = P##_horner_wide(coef, degree, x, q, &acc);                          \
+        /* any H beyond T's range clamps to the right end */                          \
+        if (sign) acc = sign > 0 ? (H)1 << (8 * sizeof(T)) : -((H)1 << (8 * sizeof(T))); \
+        return SAT(acc);                                                               \
+    }                                                                                  \
+    static inline T P##_horner(const T *coef, int degree, T x, int q) {                \
+        H acc;                                                                         \
+        if (P##_horner_wide(coef, degree, x, q, &acc)) return P##_horner_sat(coef, degree, x, q); \
+        return (T)acc;                                                                 \
+    }
+
+FIXQ_DEFINE_TYPE(fx8, int8_t, int32_t, fixq_shr32, int64_t, fixq_shr64, fixq_sat8)
+FIXQ_DEFINE_TYPE(fx16, int16_t, int32_t, fixq_shr32, int64_t, fixq_shr64, fixq_sat16)
+FIXQ_DEFINE_TYPE(fx32, int32_t, int64_t, fixq_shr64, fixq_i128, fixq_shr128, fixq_sat32)
+
+/* NAME with Q fractional bits, stored as base type P (storage T). */
+#define FIXQ_DEFINE_Q(NAME, P, T, Q)                                                   \
+    enum { NAME##_FRAC_BITS = (Q) };                                                   \
+    static inline T NAME##_from_int(int v) { return (T)((int64_t)v * ((int64_t)1 << (Q))); } \
+    static inline T NAME##_add(T a, T b) { return P##_add(a, b); }                     \
+    static inline T NAME##_sub(T a, T b) { return P##_sub(a, b); }                     \
+    static inline T NAME##_add_sat(T a, T b) { return P##_add_sat(a, b); }             \
+    static inline T NAME##_sub_sat(T a, T b) { return P##_sub_sat(a, b); }             \
+    static inline T NAME##_mul(T a, T b) { return P##_mul(a, b, (Q)); }                \
+    static inline T NAME##_mul_sat(T a, T b) { return P##_mul_sat(a, b, (Q)); }        \
+    static inline T NAME##_horner(const T *coef, int degree, T x) {                    \
+        return P##_horner(coef, degree, x, (Q));                                       \
+    }                                                                                  \
+    static inline T NAME##_horner_sat(const T *coef, int degree, T x) {                \
+        return P##_horner_sat(coef, degree, x, (Q));                                   \
+    }
+
+FIXQ_DEFINE_Q(q7, fx8, int8_t, 7)
+FIXQ_DEFINE_Q(q8_8, fx16, int16_t, 8)
+FIXQ_DEFINE_Q(q15, fx16, int16_t, 15)
+FIXQ_DEFINE_Q(q16_16, fx32, int32_t, 16)
+
+#endif // FIXED_Q_H
@@ -0,0 +1,252 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "io_buf.h"
+
+#define OUTBUF_SIZE (1u << 20)
+
+static int open_input(const char *path) {
+    return open(path, O_RDONLY);
+}
+
+static ssize_t read_full(int fd, char *buf, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+        ssize_t r = read(fd, buf + got, n - got);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (r == 0) break;
+        got += (size_t)r;
+    }
+    return (ssize_t)got;
+}
+
+int span_open(InputSpan *span, const char *path) {
+    memset(span, 0, sizeof(*span));
+    int fd = open_input(path);
+    if (fd < 0) return 0;
+
+    struct stat sb;
+    if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+        if (sb.st_size == 0) {
+            close(fd);
+            span->data = "";
+            return 1;
+        }
+        void *map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            close(fd);
+            madvise(map, (size_t)sb.st_size, MADV_SEQUENTIAL);
+            span->map = map;
+            span->data = (const char *)map;
+            span->len = (size_t)sb.st_size;
+            return 1;
+        }
+    }
+
+    /* not mappable: slurp it with large reads */
+    size_t cap = 1u << 20, len = 0;
+    char *buf = (char *)malloc(cap);
+    while (buf) {
+        if (len == cap) {
+            char *tmp = (char *)realloc(buf, cap * 2);
+            if (!tmp) break;
+            buf = tmp;
+            cap *= 2;
+        }
+        ssize_t r = read_full(fd, buf + len, cap - len);
+        if (r < 0) break;
+        len += (size_t)r;
+        if (len < cap) {
+            close(fd);
+            span->owned = buf;
+            span->data = buf;
+            span->len = len;
+            return 1;
+        }
+    }
+    free(buf);
+    close(fd);
+    return 0;
+}
+
+void span_close(InputSpan *span) {
+    if (span->map) munmap(span->map, span->len);
+    free(span->owned);
+    memset(span, 0, sizeof(*span));
+}
+
+int reader_open(InputReader *r, const char *path, size_t chunk) {
+    memset(r, 0, sizeof(*r));
+    r->fd = open_input(path);
+    if (r->fd < 0) return 0;
+    r->chunk = chunk;
+
+    struct stat sb;
+    if (fstat(r->fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+        r->size = (size_t)sb.st_size;
+        if (r->size > 0) {
+            void *map = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+            if (map != MAP_FAILED) {
+                madvise(map, r->size, MADV_SEQUENTIAL);
+                r->map = (const char *)map;
+                r->map_len = r->size;
+                return 1;
+            }
+        }
+    }
+    r->buf = (char *)malloc(chunk);
+    if (!r->buf) {
+        close(r->fd);
+        r->fd = -1;
+        return 0;
+    }
+    return 1;
+}
+
+int reader_set_chunk(InputReader *r, size_t chunk) {
+    if (r->buf && chunk > r->chunk) {
+        char *tmp = (char *)realloc(r->buf, chunk);
+        if (!tmp) return 0;
+        r->buf = tmp;
+    }
+    r->chunk = chunk;
+    return 1;
+}
+
+size_t reader_next(InputReader *r, const char **data) {
+    if (r->map) {
+        /* give back the pages of the chunks before this one */
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t done = r->pos / page * page;
+        if (done > r->released) {
+            madvise((void *)(r->map + r->released), done - r->released, MADV_DONTNEED);
+            r->released = done;
+        }
+        size_t n = r->map_len - r->pos;
+        if (n > r->chunk) n = r->chunk;
+        *data = r->map + r->pos;
+        r->pos += n;
+        return n;
+    }
+    ssize_t n = read_full(r->fd, r->buf, r->chunk);
+    if (n <= 0) return 0;
+    *data = r->buf;
+    r->pos += (size_t)n;
+    return (size_t)n;
+}
+
+int reader_skip(InputReader *r, size_t n) {
+    if (r->map) {
+        if (n > r->map_len - r->pos) return 0;
+        r->pos += n;
+        return 1;
+    }
+    while (n > 0) {
+        ssize_t got = read_full(r->fd, r->buf, n < r->chunk ? n : r->chunk);
+        if (got <= 0) return 0;
+        r->pos += (size_t)got;
+        n -= (size_t)got;
+    }
+    return 1;
+}
+
+void reader_close(InputReader *r) {
+    if (r->map) munmap((void *)r->map, r->map_len);
+    if (r->fd >= 0) close(r->fd);
+    free(r->buf);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+static int write_all(int fd, struct iovec *iov, int cnt) {
+    while (cnt > 0) {
+        ssize_t w = writev(fd, iov, cnt);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        size_t left = (size_t)w;
+        while (cnt > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    return 1;
+}
+
+int outbuf_init_fd(OutBuf *ob, int fd) {
+    memset(ob, 0, sizeof(*ob));
+    ob->fd = fd;
+    ob->cap = OUTBUF_SIZE;
+    ob->buf = (char *)malloc(ob->cap);
+    return ob->buf != NULL;
+}
+
+int outbuf_open(OutBuf *ob, const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return 0;
+    if (!outbuf_init_fd(ob, fd)) {
+        close(fd);
+        return 0;
+    }
+    ob->own_fd = 1;
+    return 1;
+}
+
+void outbuf_put(OutBuf *ob, const char *data, size_t n) {
+    if (ob->len + n <= ob->cap) {
+        memcpy(ob->buf + ob->len, data, n);
+        ob->len += n;
+        return;
+    }
+    if (n >= ob->cap / 2) {
+        struct iovec iov[2];
+        iov[0].iov_base = ob->buf;
+        iov[0].iov_len = ob->len;
+        iov[1].iov_base = (void *)data;
+        iov[1].iov_len = n;
+        if (!write_all(ob->fd, iov, 2)) ob->err = 1;
+        ob->len = 0;
+        return;
+    }
+    outbuf_flush(ob);
+    memcpy(ob->buf, data, n);
+    ob->len = n;
+}
+
+void outbuf_puts(OutBuf *ob, const char *s) {
+    outbuf_put(ob, s, strlen(s));
+}
+
+int outbuf_flush(OutBuf *ob) {
+    if (ob->len > 0) {
+        struct iovec iov;
+        iov.iov_base = ob->buf;
+        iov.iov_len = ob->len;
+        if (!write_all(ob->fd, &iov, 1)) ob->err = 1;
+        ob->len = 0;
+    }
+    return !ob->err;
+}
+
+int outbuf_close(OutBuf *ob) {
+    int ok = outbuf_flush(ob);
+    if (ob->own_fd && close(ob->fd) != 0) ok = 0;
+    free(ob->buf);
+    ob->buf = NULL;
+    return ok;
+}
@@ -0,0 +1,65 @@
+#ifndef IO_BUF_H
+#define IO_BUF_H
+
+#include <stddef.h>
+
+/* Whole input file as one read-only span: mmap'd for regular files, read()
+ * into the heap for pipes and other unmappable inputs. */
+typedef struct {
+    const char *data;
+    size_t len;
+    void *map;          /* mapping to munmap, or NULL */
+    char *owned;        /* heap copy to free, or NULL */
+} InputSpan;
+
+/* Returns 1 on success, 0 if the file cannot be opened or read. */
+int  span_open(InputSpan *span, const char *path);
+void span_close(InputSpan *span);
+
+/* Sequential chunked reader. Regular files are mapped and chunks point into
+ * the mapping (pages already consumed are dropped); other inputs are read()
+ * into one buffer of the chunk size, so memory stays bounded either way. */
+typedef struct {
+    int fd;
+    size_t size;        /* file size, 0 if unknown (pipe) */
+    const char *map;
+    size_t map_len;
+    size_t pos;
+    size_t released;    /* mapping bytes already handed back to the kernel */
+    char *buf;
+    size_t chunk;
+} InputReader;
+
+int  reader_open(InputReader *r, const char *path, size_t chunk);
+/* Changes the chunk size before the first reader_next(). Returns 0 if the
+ * buffer cannot grow to it. */
+int  reader_set_chunk(InputReader *r, size_t chunk);
+/* Points *data at the next chunk and returns its length (at most the chunk
+ * size; 0 at end of input). The chunk is valid until the next call. */
+size_t reader_next(InputReader *r, const char **data);
+/* Skips the next n bytes of input. Returns 0 if there are fewer. */
+int reader_skip(InputReader *r, size_t n);
+void reader_close(InputReader *r);
+
+/* Buffered output on a file descriptor. Small writes are gathered into a
+ * large buffer; a large write goes out together with the buffer in a single
+ * writev() without being copied. */
+typedef struct {
+    int fd;
+    int own_fd;
+    char *buf;
+    size_t len;
+    size_t cap;
+    int err;
+} OutBuf;
+
+int  outbuf_open(OutBuf *ob, const char *path);
+int  outbuf_init_fd(OutBuf *ob, int fd);
+void outbuf_put(OutBuf *ob, const char *data, size_t n);
+void outbuf_puts(OutBuf *ob, const char *s);
+/* Returns 1 if everything written so far reached the file. */
+int  outbuf_flush(OutBuf *ob);
+/* Flushes, closes the descriptor if outbuf_open() opened it, frees the buffer. */
+int  outbuf_close(OutBuf *ob);
+
+#endif // IO_BUF_H
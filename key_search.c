@@ -0,0 +1,220 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "key_search.h"
+
+#define DEFAULT_CHUNK 4096
+
+static uint8_t op_xor(uint8_t p, uint8_t k) { return (uint8_t)(p ^ k); }
+static uint8_t op_and(uint8_t p, uint8_t k) { return (uint8_t)(p & k); }
+static uint8_t op_or(uint8_t p, uint8_t k) { return (uint8_t)(p | k); }
+static uint8_t op_add(uint8_t p, uint8_t k) { return (uint8_t)(p + k); }
+
+/* Rotate left by the low three bits of the key byte. */
+static uint8_t op_rol(uint8_t p, uint8_t k) {
+    unsigned r = k & 7u;
+    return (uint8_t)((p << r) | (p >> ((8 - r) & 7u)));
+}
+
+static const KeyOp key_ops[] = {
+    { "XOR", op_xor },
+    { "AND", op_and },
+    { "OR",  op_or },
+    { "ADD", op_add },
+    { "ROL", op_rol },
+};
+
+const KeyOp *key_op_find(const char *name) {
+    for (size_t i = 0; i < sizeof(key_ops) / sizeof(key_ops[0]); i++) {
+        if (strcasecmp(key_ops[i].name, name) == 0) return &key_ops[i];
+    }
+    return NULL;
+}
+
+int key_ops_parse(const char *list, const KeyOp *ops[KEY_MAX_OPS]) {
+    int n = 0;
+    const char *p = list;
+    while (*p) {
+        const char *e = strchr(p, ',');
+        size_t len = e ? (size_t)(e - p) : strlen(p);
+        char name[16];
+        if (len == 0 || len >= sizeof(name) || n == KEY_MAX_OPS) return 0;
+        memcpy(name, p, len);
+        name[len] = '\0';
+        if (!(ops[n++] = key_op_find(name))) return 0;
+        p += len;
+        if (*p == ',') p++;
+    }
+    return n;
+}
+
+/* ---- Candidate index ----
+ * Key byte 0 is the only one that touches fingerprint byte 0, so for each
+ * operator the members are bucketed by the key bytes that map their first
+ * fingerprint byte to the first cipher byte. A key then only has to be tried
+ * on one bucket per operator; buckets keep members in order. */
+typedef struct {
+    uint32_t start[257];
+    uint32_t *members;
+} OpIndex;
+
+typedef struct {
+    const KeySearch *ks;
+    const char *fps;
+    size_t stride;
+    const uint8_t *cipher;
+    OpIndex *index;             /* one per operator */
+    uint64_t span;              /* hi - lo */
+    uint64_t chunks;
+    atomic_uint_fast64_t next_chunk;
+    atomic_uint_fast64_t bound; /* offset from lo of the lowest key matched so far */
+    pthread_mutex_t lock;
+    KeyMatch best;
+} SearchJob;
+
+static int build_index(OpIndex *ix, KeyOpFn apply, const char *fps, size_t stride, size_t count,
+                       const uint8_t cipher[KEY_FP_LEN]) {
+    /* fits[p] = key bytes b with apply(p, b) == cipher[0] */
+    uint64_t fits[256][4];
+    memset(fits, 0, sizeof(fits));
+    for (unsigned p = 0; p < 256; p++) {
+        for (unsigned b = 0; b < 256; b++) {
+            if (apply((uint8_t)p, (uint8_t)b) == cipher[0]) fits[p][b >> 6] |= 1ull << (b & 63);
+        }
+    }
+
+    memset(ix->start, 0, sizeof(ix->start));
+    for (size_t m = 0; m < count; m++) {
+        const uint64_t *f = fits[(uint8_t)fps[m * stride]];
+        for (int w = 0; w < 4; w++) {
+            for (uint64_t bits = f[w]; bits; bits &= bits - 1) ix->start[w * 64 + __builtin_ctzll(bits) + 1]++;
+        }
+    }
+    for (int b = 0; b < 256; b++) ix->start[b + 1] += ix->start[b];
+
+    ix->members = (uint32_t *)malloc((ix->start[256] ? ix->start[256] : 1) * sizeof(uint32_t));
+    if (!ix->members) return 0;
+    uint32_t fill[256];
+    memcpy(fill, ix->start, sizeof(fill));
+    for (size_t m = 0; m < count; m++) {
+        const uint64_t *f = fits[(uint8_t)fps[m * stride]];
+        for (int w = 0; w < 4; w++) {
+            for (uint64_t bits = f[w]; bits; bits &= bits - 1) {
+                ix->members[fill[w * 64 + __builtin_ctzll(bits)]++] = (uint32_t)m;
+            }
+        }
+    }
+    return 1;
+}
+
+/* First (op, member) that key k decrypts, in search order. */
+static int try_key(const SearchJob *job, uint64_t k, int *op, long *node) {
+    /* k is the key's two's complement bit pattern */
+    const KeySearch *ks = job->ks;
+    uint8_t kb[KEY_FP_LEN];
+    for (int i = 0; i < KEY_FP_LEN; i++) kb[i] = (uint8_t)(k >> (8 * (i % ks->width)));
+
+    for (int o = 0; o < ks->op_count; o++) {
+        const OpIndex *ix = &job->index[o];
+        KeyOpFn apply = ks->ops[o]->apply;
+        for (uint32_t j = ix->start[kb[0]]; j < ix->start[kb[0] + 1]; j++) {
+            uint32_t m = ix->members[j];
+            const char *fp = job->fps + (size_t)m * job->stride;
+            int i = 1;
+            while (i < KEY_FP_LEN && apply((uint8_t)fp[i], kb[i]) == job->cipher[i]) i++;
+            if (i == KEY_FP_LEN) {
+                *op = o;
+                *node = (long)m;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void *search_worker(void *arg) {
+    SearchJob *job = (SearchJob *)arg;
+    const KeySearch *ks = job->ks;
+    uint64_t chunk = ks->chunk ? ks->chunk : DEFAULT_CHUNK;
+    uint64_t c;
+    while ((c = atomic_fetch_add(&job->next_chunk, 1)) < job->chunks) {
+        /* keys are handled as offsets from lo, so the arithmetic cannot overflow */
+        uint64_t first = c * chunk;
+        /* chunks are claimed in key order: once one starts past the bound, all later ones do */
+        if (first > atomic_load_explicit(&job->bound, memory_order_relaxed)) break;
+        uint64_t last = job->span - first < chunk - 1 ? job->span : first + chunk - 1;
+        for (uint64_t off = first;; off++) {
+            int op;
+            long node;
+            if (off > atomic_load_explicit(&job->bound, memory_order_relaxed)) break;
+            if (try_key(job, (uint64_t)ks->lo + off, &op, &node)) {
+                /* the first hit in a chunk is the chunk's best; chunks never share keys */
+                pthread_mutex_lock(&job->lock);
+                if (off < atomic_load(&job->bound)) {
+                    job->best.node = node;
+                    job->best.key = (int64_t)((uint64_t)ks->lo + off);
+                    job->best.op = op;
+                    atomic_store(&job->bound, off);
+                }
+                pthread_mutex_unlock(&job->lock);
+                break;
+            }
+            if (off == last) break;
+        }
+    }
+    return NULL;
+}
+
+int key_search(const KeySearch *ks, const char *fps, size_t stride, size_t count,
+               const uint8_t cipher[KEY_FP_LEN], KeyMatch *match) {
+    match->node = -1;
+    match->key = 0;
+    match->op = 0;
+    if (ks->width < 1 || ks->width > KEY_MAX_WIDTH || ks->op_count < 1 || ks->op_count > KEY_MAX_OPS ||
+        ks->lo > ks->hi || count == 0 || count > UINT32_MAX) {
+        return count == 0 ? 0 : -1;
+    }
+
+    SearchJob job;
+    job.ks = ks;
+    job.fps = fps;
+    job.stride = stride;
+    job.cipher = cipher;
+    job.index = (OpIndex *)calloc((size_t)ks->op_count, sizeof(OpIndex));
+    if (!job.index) return -1;
+    int ok = 1;
+    for (int o = 0; o < ks->op_count && ok; o++) {
+        ok = build_index(&job.index[o], ks->ops[o]->apply, fps, stride, count, cipher);
+    }
+
+    int threads = ks->threads > 0 ? ks->threads : 1;
+    pthread_t *tids = (pthread_t *)malloc((size_t)threads * sizeof(pthread_t));
+    if (ok && tids) {
+        uint64_t chunk = ks->chunk ? ks->chunk : DEFAULT_CHUNK;
+        job.span = (uint64_t)ks->hi - (uint64_t)ks->lo;
+        job.chunks = job.span / chunk + 1;
+        atomic_init(&job.next_chunk, 0);
+        atomic_init(&job.bound, UINT64_MAX);
+        pthread_mutex_init(&job.lock, NULL);
+        job.best = *match;
+
+        int started = 0;
+        for (int t = 1; t < threads; t++) {
+            if (pthread_create(&tids[t], NULL, search_worker, &job) != 0) break;
+            started++;
+        }
+        search_worker(&job);
+        for (int t = 1; t <= started; t++) pthread_join(tids[t], NULL);
+        pthread_mutex_destroy(&job.lock);
+        *match = job.best;
+    }
+
+    for (int o = 0; o < ks->op_count; o++) free(job.index[o].members);
+    free(job.index);
+    free(tids);
+    if (!ok || !tids) return -1;
+    return match->node >= 0;
+}
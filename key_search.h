@@ -0,0 +1,59 @@
+#ifndef KEY_SEARCH_H
+#define KEY_SEARCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Length of the fingerprint prefix a cipher encrypts. */
+#define KEY_FP_LEN 9
+
+/* Widest repeating key, in bytes. Byte i of the fingerprint is combined with
+ * byte (i % width) of the key, least significant byte first. */
+#define KEY_MAX_WIDTH 4
+
+/* Most operators one search may try. */
+#define KEY_MAX_OPS 8
+
+/* A cipher operator: the cipher byte for a plain byte under one key byte. */
+typedef uint8_t (*KeyOpFn)(uint8_t plain, uint8_t key);
+
+typedef struct {
+    const char *name;   /* as printed: "XOR", "AND", "OR", "ADD", "ROL" */
+    KeyOpFn apply;
+} KeyOp;
+
+/* Looks an operator up by name, ignoring case. NULL if unknown. */
+const KeyOp *key_op_find(const char *name);
+
+/* Parses a comma separated operator list ("xor,and,rol") into ops. Returns
+ * the number of operators, 0 if the list is empty, too long or names an
+ * unknown operator. */
+int key_ops_parse(const char *list, const KeyOp *ops[KEY_MAX_OPS]);
+
+typedef struct {
+    int width;                  /* key bytes, 1..KEY_MAX_WIDTH */
+    const KeyOp *ops[KEY_MAX_OPS];
+    int op_count;
+    int64_t lo, hi;             /* keys lo..hi, inclusive; a key's bytes are
+                                   those of its two's complement value */
+    int threads;
+    uint64_t chunk;             /* keys per work unit, 0 for the default */
+} KeySearch;
+
+typedef struct {
+    long node;                  /* member ordinal, -1: no match */
+    int64_t key;
+    int op;                     /* index into KeySearch.ops */
+} KeyMatch;
+
+/* Finds the first candidate that turns a member's fingerprint into cipher,
+ * in the order keys ascending, then operators in list order, then members in
+ * order. fps holds count fingerprints, stride bytes apart. The key range is
+ * cut into chunks that idle threads claim in order; a thread that confirms a
+ * match lowers a shared bound and every thread drops the keys above it, so
+ * the answer does not depend on the thread count.
+ * Returns 1 on a match, 0 for none, -1 on failure. */
+int key_search(const KeySearch *ks, const char *fps, size_t stride, size_t count,
+               const uint8_t cipher[KEY_FP_LEN], KeyMatch *match);
+
+#endif // KEY_SEARCH_H
@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "label_scan.h"
+
+static const char *const LABELS[LABEL_COUNT] = {
+    "FirstName:", "SecondName:", "Fingerprint:", "Position:"
+};
+
+/* Aho-Corasick automaton over the four labels, flattened into a DFA. The
+ * labels share only short prefixes, so the trie has fewer than 48 states. */
+#define MAX_STATES 48
+
+static unsigned char delta[MAX_STATES][256];
+static signed char accept[MAX_STATES];   /* label ending in this state, -1 if none */
+static size_t lens[LABEL_COUNT];
+static int ready = 0;
+
+void label_scan_init(void) {
+    if (ready) return;
+
+    unsigned char fail[MAX_STATES];
+    int goto_fn[MAX_STATES][256];
+    int states = 1;
+
+    memset(goto_fn, -1, sizeof(goto_fn));
+    memset(accept, -1, sizeof(accept));
+
+    /* trie */
+    for (int l = 0; l < LABEL_COUNT; l++) {
+        int s = 0;
+        for (const char *c = LABELS[l]; *c; c++) {
+            unsigned char b = (unsigned char)*c;
+            if (goto_fn[s][b] < 0) goto_fn[s][b] = states++;
+            s = goto_fn[s][b];
+        }
+        accept[s] = (signed char)l;
+        lens[l] = strlen(LABELS[l]);
+    }
+
+    /* breadth-first failure links, folded into a full transition table */
+    int queue[MAX_STATES];
+    int head = 0, tail = 0;
+    fail[0] = 0;
+    for (int b = 0; b < 256; b++) {
+        if (goto_fn[0][b] > 0) {
+            fail[goto_fn[0][b]] = 0;
+            delta[0][b] = (unsigned char)goto_fn[0][b];
+            queue[tail++] = goto_fn[0][b];
+        } else {
+            delta[0][b] = 0;
+        }
+    }
+    while (head < tail) {
+        int s = queue[head++];
+        if (accept[s] < 0) accept[s] = accept[fail[s]];
+        for (int b = 0; b < 256; b++) {
+            int t = goto_fn[s][b];
+            if (t > 0) {
+                fail[t] = delta[fail[s]][b];
+                delta[s][b] = (unsigned char)t;
+                queue[tail++] = t;
+            } else {
+                delta[s][b] = delta[fail[s]][b];
+            }
+        }
+    }
+    ready = 1;
+}
+
+size_t label_len(LabelId label) {
+    return strlen(LABELS[label]);
+}
+
+static int push_hit(LabelHits *out, size_t pos, LabelId label) {
+    if (out->len == out->cap) {
+        size_t cap = out->cap ? out->cap * 2 : 64;
+        LabelHit *tmp = (LabelHit *)realloc(out->hits, cap * sizeof(LabelHit));
+        if (!tmp) return 0;
+        out->hits = tmp;
+        out->cap = cap;
+    }
+    out->hits[out->len].pos = pos;
+    out->hits[out->len].label = label;
+    out->len++;
+    return 1;
+}
+
+int label_scan(const char *text, size_t len, size_t from, size_t to, LabelHits *out) {
+    if (!ready) label_scan_init();
+
+    /* a label starting just before `to` ends up to LABEL_MAX_LEN - 1 bytes later */
+    size_t stop = (to + LABEL_MAX_LEN - 1 < len) ? to + LABEL_MAX_LEN - 1 : len;
+    unsigned s = 0;
+    for (size_t i = from; i < stop; i++) {
+        s = delta[s][(unsigned char)text[i]];
+        if (accept[s] >= 0) {
+            size_t start = i + 1 - lens[accept[s]];
+            if (start < to && !push_hit(out, start, (LabelId)accept[s])) return 0;
+        }
+    }
+    return 1;
+}
+
+size_t label_find(const LabelHits *hits, size_t i, LabelId label, size_t min_pos) {
+    while (i < hits->len && (hits->hits[i].label != label || hits->hits[i].pos < min_pos)) i++;
+    return i;
+}
+
+void label_hits_discard(LabelHits *hits, size_t pos) {
+    size_t i = 0;
+    while (i < hits->len && hits->hits[i].pos < pos) i++;
+    /* nothing to move when no hit is dropped (hits may still be unallocated) */
+    if (i && i < hits->len) memmove(hits->hits, hits->hits + i, (hits->len - i) * sizeof(LabelHit));
+    hits->len -= i;
+    for (size_t k = 0; k < hits->len; k++) hits->hits[k].pos -= pos;
+}
+
+void label_hits_free(LabelHits *hits) {
+    free(hits->hits);
+    hits->hits = NULL;
+    hits->len = hits->cap = 0;
+}
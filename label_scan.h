@@ -0,0 +1,48 @@
+#ifndef LABEL_SCAN_H
+#define LABEL_SCAN_H
+
+#include <stddef.h>
+
+/* Record labels as they appear in the cleaned (whitespace-free) stream. */
+typedef enum {
+    LABEL_FIRST_NAME,   /* "FirstName:" */
+    LABEL_SECOND_NAME,  /* "SecondName:" */
+    LABEL_FINGERPRINT,  /* "Fingerprint:" */
+    LABEL_POSITION,     /* "Position:" */
+    LABEL_COUNT
+} LabelId;
+
+/* Longest label, i.e. how far a match can reach past its start. */
+#define LABEL_MAX_LEN 12
+
+typedef struct {
+    size_t pos;         /* offset of the first label byte */
+    LabelId label;
+} LabelHit;
+
+typedef struct {
+    LabelHit *hits;     /* sorted by pos */
+    size_t len;
+    size_t cap;
+} LabelHits;
+
+/* Builds the matching automaton. Called implicitly by label_scan(), call it
+ * up front when several threads will scan concurrently. */
+void label_scan_init(void);
+
+size_t label_len(LabelId label);
+
+/* Single pass over text[0..len): appends every label occurrence whose first
+ * byte lies in [from, to) to out, in order. Returns 0 on allocation failure. */
+int label_scan(const char *text, size_t len, size_t from, size_t to, LabelHits *out);
+
+/* Index of the first hit at or after index i with the given label and
+ * pos >= min_pos, or hits->len if there is none. */
+size_t label_find(const LabelHits *hits, size_t i, LabelId label, size_t min_pos);
+
+/* Drops hits before pos and shifts the rest down by pos. */
+void label_hits_discard(LabelHits *hits, size_t pos);
+
+void label_hits_free(LabelHits *hits);
+
+#endif // LABEL_SCAN_H
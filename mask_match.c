@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "mask_match.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MASK_MATCH_X86 1
+#endif
+
+typedef void (*MatchKernel)(const char *fp, const uint8_t cipher[MASK_FP_LEN], int base,
+                            uint32_t *xor_hits, uint32_t *and_hits);
+
+static MatchKernel kernel = NULL;
+static const char *kernel_name = "scalar";
+
+void mask_match_scalar(const char *fp, const uint8_t cipher[MASK_FP_LEN], int base,
+                       uint32_t *xor_hits, uint32_t *and_hits) {
+    uint32_t x = 0, a = 0;
+    for (int k = 0; k < MASK_WINDOW; k++) {
+        uint8_t mask = (uint8_t)(base + k);
+        int xor_ok = 1, and_ok = 1;
+        for (int i = 0; i < MASK_FP_LEN; i++) {
+            uint8_t plain = (uint8_t)fp[i];
+            if ((uint8_t)(plain ^ mask) != cipher[i]) xor_ok = 0;
+            if ((uint8_t)(plain & mask) != cipher[i]) and_ok = 0;
+        }
+        x |= (uint32_t)xor_ok << k;
+        a |= (uint32_t)and_ok << k;
+    }
+    *xor_hits = x;
+    *and_hits = a;
+}
+
+#ifdef MASK_MATCH_X86
+
+/* One lane per mask: broadcast each fingerprint / cipher byte and compare
+ * fp ^ masks and fp & masks against it in all lanes at once. */
+__attribute__((target("sse2")))
+static void match16_sse2(const char *fp, const uint8_t cipher[MASK_FP_LEN], int base,
+                         uint32_t *xor_hits, uint32_t *and_hits) {
+    const __m128i iota = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i masks = _mm_add_epi8(_mm_set1_epi8((char)base), iota);
+    __m128i xor_eq = _mm_set1_epi8(-1);
+    __m128i and_eq = _mm_set1_epi8(-1);
+    for (int i = 0; i < MASK_FP_LEN; i++) {
+        __m128i p = _mm_set1_epi8(fp[i]);
+        __m128i c = _mm_set1_epi8((char)cipher[i]);
+        xor_eq = _mm_and_si128(xor_eq, _mm_cmpeq_epi8(_mm_xor_si128(p, masks), c));
+        and_eq = _mm_and_si128(and_eq, _mm_cmpeq_epi8(_mm_and_si128(p, masks), c));
+    }
+    *xor_hits = (uint32_t)_mm_movemask_epi8(xor_eq);
+    *and_hits = (uint32_t)_mm_movemask_epi8(and_eq);
+}
+
+__attribute__((target("sse2")))
+static void mask_match_sse2(const char *fp, const uint8_t cipher[MASK_FP_LEN], int base,
+                            uint32_t *xor_hits, uint32_t *and_hits) {
+    uint32_t xlo, alo, xhi, ahi;
+    match16_sse2(fp, cipher, base, &xlo, &alo);
+    match16_sse2(fp, cipher, base + 16, &xhi, &ahi);
+    *xor_hits = xlo | (xhi << 16);
+    *and_hits = alo | (ahi << 16);
+}
+
+__attribute__((target("avx2")))
+static void mask_match_avx2(const char *fp, const uint8_t cipher[MASK_FP_LEN], int base,
+                            uint32_t *xor_hits, uint32_t *and_hits) {
+    const __m256i iota = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                          16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+    __m256i masks = _mm256_add_epi8(_mm256_set1_epi8((char)base), iota);
+    __m256i xor_eq = _mm256_set1_epi8(-1);
+    __m256i and_eq = _mm256_set1_epi8(-1);
+    for (int i = 0; i < MASK_FP_LEN; i++) {
+        __m256i p = _mm256_set1_epi8(fp[i]);
+        __m256i c = _mm256_set1_epi8((char)cipher[i]);
+        xor_eq = _mm256_and_si256(xor_eq, _mm256_cmpeq_epi8(_mm256_xor_si256(p, masks), c));
+        and_eq = _mm256_and_si256(and_eq, _mm256_cmpeq_epi8(_mm256_and_si256(p, masks), c));
+    }
+    *xor_hits = (uint32_t)_mm256_movemask_epi8(xor_eq);
+    *and_hits = (uint32_t)_mm256_movemask_epi8(and_eq);
+}
+
+#endif
+
+void mask_match_init(void) {
+    if (kernel) return;
+#ifdef MASK_MATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernel_name = "avx2";
+        kernel = mask_match_avx2;
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        kernel_name = "sse2";
+        kernel = mask_match_sse2;
+        return;
+    }
+#endif
+    kernel_name = "scalar";
+    kernel = mask_match_scalar;
+}
+
+void mask_match(const char *fp, const uint8_t cipher[MASK_FP_LEN], int base,
+                uint32_t *xor_hits, uint32_t *and_hits) {
+    if (!kernel) mask_match_init();
+    kernel(fp, cipher, base, xor_hits, and_hits);
+}
+
+const char *mask_match_kernel_name(void) {
+    mask_match_init();
+    return kernel_name;
+}
+
+int mask_match_use(const char *name) {
+    mask_match_init();
+    if (strcmp(name, "scalar") == 0) {
+        kernel_name = "scalar";
+        kernel = mask_match_scalar;
+        return 1;
+    }
+#ifdef MASK_MATCH_X86
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        kernel_name = "sse2";
+        kernel = mask_match_sse2;
+        return 1;
+    }
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        kernel_name = "avx2";
+        kernel = mask_match_avx2;
+        return 1;
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef MASK_MATCH_H
+#define MASK_MATCH_H
+
+#include <stdint.h>
+
+/* Length of the fingerprint prefix a cipher encrypts. */
+#define MASK_FP_LEN 9
+
+/* Number of consecutive masks tested per call. */
+#define MASK_WINDOW 32
+
+/* Picks the fastest kernel for this CPU. Called implicitly by mask_match(),
+ * call it up front when several threads will match concurrently. */
+void mask_match_init(void);
+
+/* Tests fp against cipher under the masks base, base + 1, ..., base + 31
+ * (each truncated to a byte) with both operators at once. Bit k of
+ * *xor_hits is set when fp ^ mask_k == cipher for all MASK_FP_LEN bytes,
+ * bit k of *and_hits likewise for fp & mask_k. */
+void mask_match(const char *fp, const uint8_t cipher[MASK_FP_LEN], int base,
+                uint32_t *xor_hits, uint32_t *and_hits);
+
+/* Reference byte-at-a-time implementation. */
+void mask_match_scalar(const char *fp, const uint8_t cipher[MASK_FP_LEN], int base,
+                       uint32_t *xor_hits, uint32_t *and_hits);
+
+/* Name of the kernel mask_match() dispatches to ("avx2", "sse2", "scalar"). */
+const char *mask_match_kernel_name(void);
+
+/* Makes mask_match() dispatch to the named kernel instead of the one picked
+ * for this CPU, e.g. to compare them. Returns 0 and changes nothing if this
+ * CPU or build cannot run it. */
+int mask_match_use(const char *name);
+
+#endif // MASK_MATCH_H
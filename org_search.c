@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "org_search.h"
+#include "mask_match.h"
+#include "stats.h"
+
+const char OP_XOR[] = "XOR";
+const char OP_AND[] = "AND";
+
+#define SUCCESS_FMT "Successful Decrypt! The Mask used was mask_%lld of type (%s) and The fingerprint was %.*s belonging to %s %s\n"
+#define UNSUCCESS_MSG "Unsuccesful decrypt, Looks like he got away\n"
+
+/* ---- Analytic solver ----
+ * Instead of trying every mask against every member, derive per member the
+ * masks that work: XOR fixes the mask from the first byte (fp[0] ^ c[0]) and
+ * the other bytes only confirm it; AND works for exactly the masks that
+ * contain every bit set in some cipher byte and no bit that some fingerprint
+ * byte has but its cipher byte lacks. */
+
+/* Smallest m >= lo whose low byte is b. */
+static int first_mask_with_byte(int lo, uint8_t b) {
+    return lo + (uint8_t)(b - (uint8_t)lo);
+}
+
+static int solve_xor(const char fp[ORG_FP_WIDTH], const uint8_t cipher[MASK_FP_LEN], uint8_t *mask) {
+    uint8_t m = (uint8_t)((uint8_t)fp[0] ^ cipher[0]);
+    for (int i = 1; i < MASK_FP_LEN; i++) {
+        if ((uint8_t)((uint8_t)fp[i] ^ m) != cipher[i]) return 0;
+    }
+    *mask = m;
+    return 1;
+}
+
+/* Feasible AND masks are { v : (v & ones) == ones && (v & zeros) == 0 }. */
+static int solve_and(const char fp[ORG_FP_WIDTH], const uint8_t cipher[MASK_FP_LEN], uint8_t *ones, uint8_t *zeros) {
+    uint8_t o = 0, z = 0;
+    for (int i = 0; i < MASK_FP_LEN; i++) {
+        uint8_t p = (uint8_t)fp[i];
+        if (cipher[i] & (uint8_t)~p) return 0;   /* AND cannot set a bit */
+        o |= cipher[i];
+        z |= (uint8_t)(p & (uint8_t)~cipher[i]);
+    }
+    if (o & z) return 0;
+    *ones = o;
+    *zeros = z;
+    return 1;
+}
+
+/* Smallest m >= lo whose low byte is a feasible AND mask. */
+static int first_and_mask(int lo, uint8_t ones, uint8_t zeros) {
+    uint8_t start = (uint8_t)lo;
+    uint8_t free_bits = (uint8_t)~(ones | zeros);
+    /* submasks of free_bits in increasing order give feasible bytes in increasing order */
+    unsigned x = 0;
+    while (1) {
+        unsigned v = ones | x;
+        if (v >= start) return lo + (int)(v - start);
+        if (x == free_bits) break;
+        x = (x - free_bits) & free_bits;
+    }
+    /* wrap to the next block of 256: the smallest feasible byte is `ones` */
+    return lo + (256 - start) + ones;
+}
+
+Solution solve_masks(const OrgFlat *org, const uint8_t cipher[MASK_FP_LEN], int lo, int hi) {
+    Solution best = { -1, hi + 1, OP_AND };
+    uint64_t nodes_tested = 0;
+    for (size_t i = 0; i < org->count; i++) {
+        nodes_tested++;
+        const char *fp = org->fingerprints[i];
+        uint8_t m, ones, zeros;
+        if (solve_xor(fp, cipher, &m)) {
+            int mask = first_mask_with_byte(lo, m);
+            /* XOR ranks ahead of AND for the same mask */
+            if (mask <= hi && (mask < best.mask || (mask == best.mask && best.op != OP_XOR))) {
+                best.node = (long)i;
+                best.mask = mask;
+                best.op = OP_XOR;
+            }
+        }
+        if (solve_and(fp, cipher, &ones, &zeros)) {
+            int mask = first_and_mask(lo, ones, zeros);
+            if (mask <= hi && mask < best.mask) {
+                best.node = (long)i;
+                best.mask = mask;
+                best.op = OP_AND;
+            }
+        }
+        if (best.node >= 0 && best.mask == lo && best.op == OP_XOR) break;
+    }
+    /* each member is solved for both operators at once */
+    STAT_COUNT(STAT_NODES_TESTED, nodes_tested);
+    STAT_COUNT(STAT_MASKS_TESTED, 2 * nodes_tested);
+    return best;
+}
+
+/* Masks s..s+10 in order, XOR before AND, members in search order. XOR
+ * fixes the plain fingerprint, so each mask is a single index probe. AND
+ * only runs the vector kernel (whole window at once) on the first-byte
+ * buckets that some remaining mask can AND down to the cipher's first byte;
+ * the lowest (mask, operator) hit wins and ties go to the earlier member,
+ * which is the order the one-mask-at-a-time loop checks. */
+Solution find_match_in_org(const OrgFlat *org, const OrgIndex *ix, const uint8_t cipher[MASK_FP_LEN], int s) {
+    const uint32_t window = (1u << MASK_SPAN) - 1;
+    Solution sol = { -1, 0, OP_XOR };
+    int best_key = 2 * MASK_SPAN;    /* 2 * mask offset + (AND ? 1 : 0) */
+    uint64_t masks_tested = 0, nodes_tested = 0;
+
+    for (int k = 0; k < MASK_SPAN; k++) {
+        uint8_t plain[ORG_INDEX_KEY];
+        for (int i = 0; i < MASK_FP_LEN; i++) plain[i] = (uint8_t)(cipher[i] ^ (uint8_t)(s + k));
+        long i = org_index_lookup(ix, plain);
+        masks_tested++;
+        if (i >= 0) {
+            best_key = 2 * k;
+            sol.node = i;
+            break;
+        }
+    }
+
+    for (unsigned b = 0; b < 256 && best_key > 0; b++) {
+        /* masks not behind the best so far (an equal AND may still come from
+         * an earlier member) that take first byte b to cipher[0] */
+        uint32_t fits = 0;
+        for (int k = 0; 2 * k + 1 <= best_key; k++) {
+            if ((uint8_t)(b & (uint8_t)(s + k)) == cipher[0]) fits |= 1u << k;
+        }
+        if (!fits) continue;
+        nodes_tested += ix->by_first_start[b + 1] - ix->by_first_start[b];
+        masks_tested += (uint64_t)__builtin_popcount(fits) * (ix->by_first_start[b + 1] - ix->by_first_start[b]);
+        for (uint32_t j = ix->by_first_start[b]; j < ix->by_first_start[b + 1]; j++) {
+            uint32_t i = ix->by_first[j];
+            uint32_t xor_hits, and_hits;
+            mask_match(org->fingerprints[i], cipher, s, &xor_hits, &and_hits);
+            and_hits &= window & fits;
+            if (!and_hits) continue;
+            int key = 2 * __builtin_ctz(and_hits) + 1;
+            if (key < best_key || (key == best_key && (long)i < sol.node)) {
+                best_key = key;
+                sol.node = (long)i;
+            }
+        }
+    }
+    if (sol.node >= 0) {
+        sol.mask = s + best_key / 2;
+        sol.op = (best_key & 1) ? OP_AND : OP_XOR;
+    }
+    STAT_COUNT(STAT_MASKS_TESTED, masks_tested);
+    STAT_COUNT(STAT_NODES_TESTED, nodes_tested);
+    return sol;
+}
+
+
+size_t format_solution(char *buf, size_t cap, const OrgFlat *org, const Solution *sol) {
+    int n;
+    if (sol->node < 0) {
+        n = snprintf(buf, cap, UNSUCCESS_MSG);
+    } else {
+        size_t i = (size_t)sol->node;
+        n = snprintf(buf, cap, SUCCESS_FMT, sol->mask, sol->op, MASK_FP_LEN, org_flat_fingerprint(org, i),
+                     org_flat_first(org, i), org_flat_second(org, i));
+    }
+    if (n < 0) return 0;
+    return (size_t)n < cap ? (size_t)n : cap - 1;
+}
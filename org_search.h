@@ -0,0 +1,39 @@
+#ifndef ORG_SEARCH_H
+#define ORG_SEARCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "org_tree.h"
+#include "mask_match.h"
+
+/* The single-byte XOR / AND mask searches ex2 runs over an OrgFlat. */
+
+typedef struct {
+    long node;      /* -1: no match */
+    long long mask;
+    const char *op; /* operator name as printed */
+} Solution;
+
+extern const char OP_XOR[];     /* "XOR" */
+extern const char OP_AND[];     /* "AND" */
+
+/* Masks searched from the start mask s: s .. s + MASK_SPAN - 1. */
+#define MASK_SPAN 11
+
+/* Masks s..s+10 in order, XOR before AND, members in search order, using
+ * the org's fingerprint index. */
+Solution find_match_in_org(const OrgFlat *org, const OrgIndex *ix, const uint8_t cipher[MASK_FP_LEN], int s);
+
+/* One pass over the org. Picks the same answer as trying masks lo..hi in
+ * order, XOR before AND, members in search order. */
+Solution solve_masks(const OrgFlat *org, const uint8_t cipher[MASK_FP_LEN], int lo, int hi);
+
+/* Room for any line format_solution() writes. */
+#define SOLUTION_LINE_MAX 512
+
+/* The result line ex2 prints for sol: "Successful Decrypt! ..." with the
+ * member's name, or the unsuccessful message. Returns its length. */
+size_t format_solution(char *buf, size_t cap, const OrgFlat *org, const Solution *sol);
+
+#endif // ORG_SEARCH_H
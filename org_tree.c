@@ -2,60 +2,137 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "org_tree.h"
+#include "cleaner.h"
+#include "io_buf.h"
+#include "stats.h"
+
+/* A slice of the input; the parser never copies a line, only final values. */
+typedef struct {
+    const char *p;
+    size_t n;
+} StrView;
+
+static StrView trim_view(StrView v) {
+    while (v.n > 0 && isspace((unsigned char)v.p[0])) {
+        v.p++;
+        v.n--;
+    }
+    while (v.n > 0 && isspace((unsigned char)v.p[v.n - 1])) v.n--;
+    return v;
+}
+
+/* Next line of data[*pos..len) (any length), trimmed. Returns 0 at end of data. */
+static int next_line(const char *data, size_t len, size_t *pos, StrView *line) {
+    if (*pos >= len) return 0;
+    const char *start = data + *pos;
+    const char *nl = (const char *)memchr(start, '\n', len - *pos);
+    size_t n = nl ? (size_t)(nl - start) : len - *pos;
+    *pos += nl ? n + 1 : n;
+    line->p = start;
+    line->n = n;
+    *line = trim_view(*line);
+    return 1;
+}
 
-static void trim_inplace(char *s) {
-    if (!s) return;
-    size_t n = strlen(s);
-    size_t i = 0;
-    while (i < n && isspace((unsigned char)s[i])) i++;
-    if (i > 0) memmove(s, s + i, n - i + 1);
-    n = strlen(s);
-    while (n > 0 && isspace((unsigned char)s[n - 1])) {
-        s[n - 1] = '\0';
-        n--;
-    }
-}
-
-static int starts_with(const char *line, const char *prefix) {
-    return strncmp(line, prefix, strlen(prefix)) == 0;
-}
-
-static void extract_value(char *dst, size_t dst_cap, const char *line, const char *prefix) {
-    if (!dst || dst_cap == 0) return;
-    dst[0] = '\0';
-    if (!line || !prefix) return;
-    const char *p = line + strlen(prefix);
-    while (*p && isspace((unsigned char)*p)) p++;
-    strncpy(dst, p, dst_cap - 1);
-    dst[dst_cap - 1] = '\0';
-    trim_inplace(dst);
-}
-
-static Node *new_node_from_fields(const char *first, const char *second, const char *fingerprint, const char *position) {
-    Node *n = (Node *)calloc(1, sizeof(Node));
-    if (!n) return NULL;
-    strncpy(n->first, first ? first : "", MAX_FIELD - 1);
-    strncpy(n->second, second ? second : "", MAX_FIELD - 1);
-    strncpy(n->fingerprint, fingerprint ? fingerprint : "", MAX_FIELD - 1);
-    strncpy(n->position, position ? position : "", MAX_POS - 1);
-    n->left = n->right = NULL;
-    n->supports_head = NULL;
-    n->next = NULL;
+static int starts_with(StrView line, const char *prefix) {
+    size_t n = strlen(prefix);
+    return line.n >= n && memcmp(line.p, prefix, n) == 0;
+}
+
+/* Copies the value after the label into dst (truncated to dst_cap - 1 and
+ * re-trimmed). Like the line format itself, the label text is not checked. */
+static void extract_value(char *dst, size_t dst_cap, StrView line, const char *prefix) {
+    size_t skip = strlen(prefix);
+    StrView v = { line.p + (skip < line.n ? skip : line.n), skip < line.n ? line.n - skip : 0 };
+    v = trim_view(v);
+    if (v.n > dst_cap - 1) v.n = dst_cap - 1;
+    while (v.n > 0 && isspace((unsigned char)v.p[v.n - 1])) v.n--;
+    memcpy(dst, v.p, v.n);
+    dst[v.n] = '\0';
+}
+
+/* Nodes are carved out of slabs owned by the Org; each slab is twice the size
+ * of the previous one, so n nodes cost O(log n) mallocs and free_org releases
+ * them all by walking the short slab chain. */
+#define FIRST_SLAB_NODES 32
+#define MAX_SLAB_NODES   65536
+
+struct NodeSlab {
+    NodeSlab *next;
+    size_t used;
+    size_t cap;
+    Node nodes[];
+};
+
+static Node *pool_alloc(Org *org) {
+    NodeSlab *slab = org->slabs;
+    if (!slab || slab->used == slab->cap) {
+        size_t cap = slab ? slab->cap * 2 : FIRST_SLAB_NODES;
+        if (cap > MAX_SLAB_NODES) cap = MAX_SLAB_NODES;
+        NodeSlab *fresh = (NodeSlab *)malloc(sizeof(NodeSlab) + cap * sizeof(Node));
+        if (!fresh) return NULL;
+        fresh->next = slab;
+        fresh->used = 0;
+        fresh->cap = cap;
+        org->slabs = slab = fresh;
+    }
+    Node *n = &slab->nodes[slab->used++];
+    memset(n, 0, sizeof(Node));
     return n;
 }
 
-static void append_support(Node *hand, Node *support) {
+/* Gives back the node returned by the last pool_alloc. */
+static void pool_unalloc(Org *org) {
+    org->slabs->used--;
+}
+
+static void append_support(Node *hand, Node **tail, Node *support) {
     if (!hand || !support) return;
     support->next = NULL;
     if (!hand->supports_head) {
         hand->supports_head = support;
-        return;
+    } else {
+        (*tail)->next = support;
+    }
+    *tail = support;
+}
+
+/* Hangs a freshly allocated node into the org by its position. Returns 0
+ * for an unknown position; the caller gives the node back. */
+static int place_node(Org *org, Node *node) {
+    const char *pos = node->position;
+    if (strcmp(pos, "Boss") == 0) {
+        org->boss = node;
+    } else if (strcmp(pos, "Left Hand") == 0 || strcmp(pos, "Left_Hand") == 0) {
+        org->left_hand = node;
+        org->left_tail = NULL;
+    } else if (strcmp(pos, "Right Hand") == 0 || strcmp(pos, "Right_Hand") == 0) {
+        org->right_hand = node;
+        org->right_tail = NULL;
+    } else if (strcmp(pos, "Support_Left") == 0 || strcmp(pos, "Support Left") == 0) {
+        append_support(org->left_hand, &org->left_tail, node);
+    } else if (strcmp(pos, "Support_Right") == 0 || strcmp(pos, "Support Right") == 0) {
+        append_support(org->right_hand, &org->right_tail, node);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+/* Connects the tree pointers once every node is placed. */
+static void link_hands(Org *org) {
+    if (org->boss) {
+        org->boss->left = org->left_hand;
+        org->boss->right = org->right_hand;
     }
-    Node *cur = hand->supports_head;
-    while (cur->next) cur = cur->next;
-    cur->next = support;
 }
 
 static void print_node(const Node *n) {
@@ -66,93 +143,112 @@ static void print_node(const Node *n) {
     printf("Position: %s\n\n", n->position);
 }
 
-static void free_support_list(Node *head) {
-    while (head) {
-        Node *next = head->next;
-        free(head);
-        head = next;
-    }
-}
-
 Org build_org_from_clean_file(const char *path) {
     Org org;
-    org.boss = NULL;
-    org.left_hand = NULL;
-    org.right_hand = NULL;
+    memset(&org, 0, sizeof(org));
 
-    FILE *fp = fopen(path, "r");
-    if (!fp) {
+    InputSpan span;
+    STAT_TIMER_START(STAT_ORG_READ);
+    int opened = span_open(&span, path);
+    STAT_TIMER_STOP(STAT_ORG_READ);
+    if (!opened) {
         /* As per assignment: print error and return gracefully */
         printf("Error opening file: %s\n", path);
         return org;
     }
+    org = build_org_from_buffer(span.data, span.len);
+    span_close(&span);
+    return org;
+}
+
+Org build_org_from_buffer(const char *data, size_t len) {
+    Org org;
+    memset(&org, 0, sizeof(org));
 
-    char line[512];
-    char first[MAX_FIELD], second[MAX_FIELD], fingerprint[MAX_FIELD], position[MAX_POS];
+    size_t at = 0;
+    StrView line;
+    uint64_t members = 0, unknown = 0;
+    STAT_TIMER_START(STAT_ORG_PARSE);
 
-    while (fgets(line, sizeof(line), fp)) {
-        trim_inplace(line);
-        if (line[0] == '\0') continue;
+    while (next_line(data, len, &at, &line)) {
+        /* blank lines (including the optional one between entries) are skipped here */
+        if (line.n == 0) continue;
 
         if (!starts_with(line, "First Name:")) {
             /* Unexpected line - skip until next possible entry */
             continue;
         }
-        extract_value(first, sizeof(first), line, "First Name:");
-
-        if (!fgets(line, sizeof(line), fp)) break;
-        trim_inplace(line);
-        extract_value(second, sizeof(second), line, "Second Name:");
-
-        if (!fgets(line, sizeof(line), fp)) break;
-        trim_inplace(line);
-        extract_value(fingerprint, sizeof(fingerprint), line, "Fingerprint:");
-
-        if (!fgets(line, sizeof(line), fp)) break;
-        trim_inplace(line);
-        extract_value(position, sizeof(position), line, "Position:");
+        StrView first = line, second, fingerprint, position;
+        if (!next_line(data, len, &at, &second)) break;
+        if (!next_line(data, len, &at, &fingerprint)) break;
+        if (!next_line(data, len, &at, &position)) break;
 
-        Node *node = new_node_from_fields(first, second, fingerprint, position);
+        /* values are copied exactly once, straight into the node */
+        Node *node = pool_alloc(&org);
         if (!node) {
             printf("Memory allocation failed\n");
-            fclose(fp);
             free_org(&org);
             return org;
         }
+        extract_value(node->first, sizeof(node->first), first, "First Name:");
+        extract_value(node->second, sizeof(node->second), second, "Second Name:");
+        extract_value(node->fingerprint, sizeof(node->fingerprint), fingerprint, "Fingerprint:");
+        extract_value(node->position, sizeof(node->position), position, "Position:");
+        members++;
 
-        if (strcmp(position, "Boss") == 0) {
-            org.boss = node;
-        } else if (strcmp(position, "Left Hand") == 0 || strcmp(position, "Left_Hand") == 0) {
-            org.left_hand = node;
-        } else if (strcmp(position, "Right Hand") == 0 || strcmp(position, "Right_Hand") == 0) {
-            org.right_hand = node;
-        } else if (strcmp(position, "Support_Left") == 0 || strcmp(position, "Support Left") == 0) {
-            append_support(org.left_hand, node);
-        } else if (strcmp(position, "Support_Right") == 0 || strcmp(position, "Support Right") == 0) {
-            append_support(org.right_hand, node);
-        } else {
+        if (!place_node(&org, node)) {
             /* Unknown position: free and ignore */
-            free(node);
-        }
-
-        /*optional blank line between entries */
-        long pos = ftell(fp);
-        if (fgets(line, sizeof(line), fp)) {
-            trim_inplace(line);
-            if (line[0] != '\0') {
-                fseek(fp, pos, SEEK_SET);
-            }
+            pool_unalloc(&org);
+            unknown++;
         }
     }
+    STAT_TIMER_STOP(STAT_ORG_PARSE);
+    STAT_COUNT(STAT_ORG_MEMBERS, members);
+    STAT_COUNT(STAT_UNKNOWN_FREED, unknown);
 
-    fclose(fp);
+    link_hands(&org);
+    return org;
+}
 
-    /* Connect tree pointers */
-    if (org.boss) {
-        org.boss->left = org.left_hand;
-        org.boss->right = org.right_hand;
+/* Like extract_value for a value that is already trimmed. */
+static void copy_value(char *dst, size_t dst_cap, const char *src) {
+    size_t n = strlen(src);
+    if (n > dst_cap - 1) n = dst_cap - 1;
+    while (n > 0 && isspace((unsigned char)src[n - 1])) n--;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+Org build_org_from_list(const struct CleanList *list) {
+    Org org;
+    memset(&org, 0, sizeof(org));
+
+    size_t count = list->entries.count;
+    uint64_t unknown = 0;
+    STAT_TIMER_START(STAT_ORG_PARSE);
+    for (size_t i = 0; i < count; i++) {
+        CleanRef e;
+        clean_list_get(list, i, &e);
+        Node *node = pool_alloc(&org);
+        if (!node) {
+            printf("Memory allocation failed\n");
+            free_org(&org);
+            return org;
+        }
+        copy_value(node->first, sizeof(node->first), e.first);
+        copy_value(node->second, sizeof(node->second), e.second);
+        copy_value(node->fingerprint, sizeof(node->fingerprint), e.fingerprint);
+        copy_value(node->position, sizeof(node->position), e.position);
+        if (!place_node(&org, node)) {
+            pool_unalloc(&org);
+            unknown++;
+        }
     }
+    STAT_TIMER_STOP(STAT_ORG_PARSE);
+    STAT_COUNT(STAT_ORG_MEMBERS, count);
+    STAT_COUNT(STAT_UNKNOWN_FREED, unknown);
 
+    link_hands(&org);
     return org;
 }
 
@@ -183,20 +279,796 @@ void print_tree_order(const Org *org) {
 void free_org(Org *org) {
     if (!org) return;
 
+    NodeSlab *slab = org->slabs;
+    while (slab) {
+        NodeSlab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    memset(org, 0, sizeof(*org));
+}
+
+/* ---- Compact representation ---- */
+
+static const char *const POSITION_NAMES[ORG_POS_COUNT] = {
+    "Boss", "Left Hand", "Support_Left", "Right Hand", "Support_Right"
+};
+
+/* Nodes of org in print / search order. Returns how many were stored. */
+static size_t collect_nodes(const Org *org, const Node **out, uint8_t *pos) {
+    size_t n = 0;
+    if (!org || !org->boss) return 0;
+
+    out[n] = org->boss;
+    pos[n++] = ORG_POS_BOSS;
+    if (org->left_hand) {
+        out[n] = org->left_hand;
+        pos[n++] = ORG_POS_LEFT_HAND;
+        for (const Node *s = org->left_hand->supports_head; s; s = s->next) {
+            out[n] = s;
+            pos[n++] = ORG_POS_SUPPORT_LEFT;
+        }
+    }
+    if (org->right_hand) {
+        out[n] = org->right_hand;
+        pos[n++] = ORG_POS_RIGHT_HAND;
+        for (const Node *s = org->right_hand->supports_head; s; s = s->next) {
+            out[n] = s;
+            pos[n++] = ORG_POS_SUPPORT_RIGHT;
+        }
+    }
+    return n;
+}
+
+static size_t count_nodes(const Org *org) {
+    size_t n = 0;
+    if (!org || !org->boss) return 0;
+    n++;
     if (org->left_hand) {
-        free_support_list(org->left_hand->supports_head);
-        org->left_hand->supports_head = NULL;
+        n++;
+        for (const Node *s = org->left_hand->supports_head; s; s = s->next) n++;
     }
     if (org->right_hand) {
-        free_support_list(org->right_hand->supports_head);
-        org->right_hand->supports_head = NULL;
+        n++;
+        for (const Node *s = org->right_hand->supports_head; s; s = s->next) n++;
+    }
+    return n;
+}
+
+static size_t align_up(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+/* Carves the arrays of flat out of one block of block_len bytes laid out as
+ * computed by flat_layout(). */
+static void flat_layout(OrgFlat *flat, size_t count, size_t strings_len, char *block, size_t *block_len) {
+    size_t off = 0;
+    size_t fps = off;
+    off = align_up(off + count * ORG_FP_WIDTH, 8);
+    size_t firsts = off;
+    off += count * sizeof(uint32_t);
+    size_t seconds = off;
+    off += count * sizeof(uint32_t);
+    size_t fpstrs = off;
+    off += count * sizeof(uint32_t);
+    size_t positions = off;
+    off += count;
+    size_t strings = off;
+    off = align_up(off + strings_len, 64);
+    *block_len = off;
+    if (!block) return;
+
+    flat->count = count;
+    flat->fingerprints = (const char (*)[ORG_FP_WIDTH])(block + fps);
+    flat->first_off = (const uint32_t *)(block + firsts);
+    flat->second_off = (const uint32_t *)(block + seconds);
+    flat->fingerprint_off = (const uint32_t *)(block + fpstrs);
+    flat->position = (const uint8_t *)(block + positions);
+    flat->strings = block + strings;
+    flat->strings_len = strings_len;
+}
+
+int org_flat_from_org(const Org *org, OrgFlat *flat) {
+    memset(flat, 0, sizeof(*flat));
+    size_t count = count_nodes(org);
+    if (count == 0) return 1;
+
+    const Node **nodes = (const Node **)malloc(count * sizeof(Node *));
+    uint8_t *pos = (uint8_t *)malloc(count);
+    if (!nodes || !pos) {
+        free(nodes);
+        free(pos);
+        return 0;
+    }
+    collect_nodes(org, nodes, pos);
+
+    size_t strings_len = 0;
+    for (size_t i = 0; i < count; i++) {
+        strings_len += strlen(nodes[i]->first) + strlen(nodes[i]->second) + strlen(nodes[i]->fingerprint) + 3;
+    }
+
+    size_t block_len;
+    flat_layout(flat, count, strings_len, NULL, &block_len);
+    char *block = (char *)aligned_alloc(64, block_len);
+    if (!block) {
+        free(nodes);
+        free(pos);
+        return 0;
+    }
+    memset(block, 0, block_len);
+    flat_layout(flat, count, strings_len, block, &block_len);
+    flat->block = block;
+    flat->block_len = block_len;
+
+    char (*fps)[ORG_FP_WIDTH] = (char (*)[ORG_FP_WIDTH])flat->fingerprints;
+    uint32_t *firsts = (uint32_t *)flat->first_off;
+    uint32_t *seconds = (uint32_t *)flat->second_off;
+    uint32_t *fpstrs = (uint32_t *)flat->fingerprint_off;
+    char *strings = (char *)flat->strings;
+    size_t at = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Node *n = nodes[i];
+        size_t fl = strlen(n->fingerprint);
+        memcpy(fps[i], n->fingerprint, fl < ORG_FP_WIDTH ? fl : ORG_FP_WIDTH);
+
+        size_t l = strlen(n->first) + 1;
+        memcpy(strings + at, n->first, l);
+        firsts[i] = (uint32_t)at;
+        at += l;
+        l = strlen(n->second) + 1;
+        memcpy(strings + at, n->second, l);
+        seconds[i] = (uint32_t)at;
+        at += l;
+        memcpy(strings + at, n->fingerprint, fl + 1);
+        fpstrs[i] = (uint32_t)at;
+        at += fl + 1;
+    }
+    memcpy((uint8_t *)flat->position, pos, count);
+
+    free(nodes);
+    free(pos);
+    return 1;
+}
+
+void org_flat_free(OrgFlat *flat) {
+    if (!flat) return;
+    if (flat->map) munmap(flat->map, flat->map_len);
+    else free(flat->block);
+    memset(flat, 0, sizeof(*flat));
+}
+
+const char *org_flat_first(const OrgFlat *flat, size_t i) {
+    return flat->strings + flat->first_off[i];
+}
+
+const char *org_flat_second(const OrgFlat *flat, size_t i) {
+    return flat->strings + flat->second_off[i];
+}
+
+const char *org_flat_fingerprint(const OrgFlat *flat, size_t i) {
+    return flat->strings + flat->fingerprint_off[i];
+}
+
+OrgPosition org_flat_position(const OrgFlat *flat, size_t i) {
+    return (OrgPosition)flat->position[i];
+}
+
+const char *org_position_name(OrgPosition pos) {
+    return (pos < ORG_POS_COUNT) ? POSITION_NAMES[pos] : "";
+}
+
+void print_tree_order_flat(const OrgFlat *flat) {
+    /* entries are stored in print order already */
+    for (size_t i = 0; flat && i < flat->count; i++) {
+        printf("First Name: %s\n", org_flat_first(flat, i));
+        printf("Second Name: %s\n", org_flat_second(flat, i));
+        printf("Fingerprint: %s\n", org_flat_fingerprint(flat, i));
+        printf("Position: %s\n\n", org_position_name(org_flat_position(flat, i)));
+    }
+}
+
+/* ---- Fingerprint index ---- */
+
+static uint32_t index_hash(const uint8_t key[ORG_INDEX_KEY]) {
+    uint64_t w;
+    memcpy(&w, key, sizeof(w));
+    uint64_t h = (w ^ key[8] * 0xFF51AFD7ED558CCDULL) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(h >> 32);
+}
+
+static void index_key(uint8_t key[ORG_INDEX_KEY], const char *fp, size_t len) {
+    memset(key, 0, ORG_INDEX_KEY);
+    memcpy(key, fp, len < ORG_INDEX_KEY ? len : ORG_INDEX_KEY);
+}
+
+/* Allocates for count members; the caller fills keys (and nodes). */
+static int index_alloc(OrgIndex *ix, size_t count, int with_nodes) {
+    memset(ix, 0, sizeof(*ix));
+    if (count >= UINT32_MAX) return 0;
+    size_t cap = 16;
+    while (cap < count * 2) cap *= 2;
+    ix->count = count;
+    ix->slot_mask = cap - 1;
+    ix->keys = (uint8_t (*)[ORG_INDEX_KEY])malloc((count ? count : 1) * ORG_INDEX_KEY);
+    ix->slots = (uint64_t *)calloc(cap, sizeof(uint64_t));
+    ix->by_first = (uint32_t *)malloc((count ? count : 1) * sizeof(uint32_t));
+    if (with_nodes) {
+        ix->nodes = (Node **)malloc((count ? count : 1) * sizeof(Node *));
+        ix->same_key = (uint32_t *)calloc(count ? count : 1, sizeof(uint32_t));
+    }
+    if (!ix->keys || !ix->slots || !ix->by_first || (with_nodes && (!ix->nodes || !ix->same_key))) {
+        org_index_free(ix);
+        return 0;
+    }
+    return 1;
+}
+
+/* Hashes every key (first occurrence wins) and fills the first-byte buckets. */
+static void index_fill(OrgIndex *ix) {
+    for (size_t i = 0; i < ix->count; i++) {
+        uint32_t h = index_hash(ix->keys[i]);
+        size_t s = h & ix->slot_mask;
+        while (ix->slots[s]) {
+            uint64_t slot = ix->slots[s];
+            if ((uint32_t)(slot >> 32) == h && memcmp(ix->keys[(uint32_t)slot - 1], ix->keys[i], ORG_INDEX_KEY) == 0) break;
+            s = (s + 1) & ix->slot_mask;
+        }
+        if (!ix->slots[s]) ix->slots[s] = ((uint64_t)h << 32) | (uint64_t)(i + 1);
+    }
+
+    /* members after the first with a key chain off it in order: linking
+     * from the back puts each one right behind the first */
+    for (size_t i = ix->count; ix->same_key && i-- > 0;) {
+        long first = org_index_lookup(ix, ix->keys[i]);
+        if (first < 0 || (size_t)first == i) continue;
+        ix->same_key[i] = ix->same_key[first];
+        ix->same_key[first] = (uint32_t)(i + 1);
+    }
+
+    memset(ix->by_first_start, 0, sizeof(ix->by_first_start));
+    for (size_t i = 0; i < ix->count; i++) ix->by_first_start[ix->keys[i][0] + 1]++;
+    for (int b = 0; b < 256; b++) ix->by_first_start[b + 1] += ix->by_first_start[b];
+    uint32_t fill[256];
+    memcpy(fill, ix->by_first_start, sizeof(fill));
+    for (size_t i = 0; i < ix->count; i++) ix->by_first[fill[ix->keys[i][0]]++] = (uint32_t)i;
+}
+
+int org_index_build(const Org *org, OrgIndex *ix) {
+    size_t count = count_nodes(org);
+    if (!index_alloc(ix, count, 1)) return 0;
+    uint8_t *pos = (uint8_t *)malloc(count ? count : 1);
+    if (!pos) {
+        org_index_free(ix);
+        return 0;
+    }
+    collect_nodes(org, (const Node **)ix->nodes, pos);
+    free(pos);
+    for (size_t i = 0; i < count; i++) {
+        index_key(ix->keys[i], ix->nodes[i]->fingerprint, strlen(ix->nodes[i]->fingerprint));
+    }
+    index_fill(ix);
+    return 1;
+}
+
+int org_index_build_flat(const OrgFlat *flat, OrgIndex *ix) {
+    if (!index_alloc(ix, flat->count, 0)) return 0;
+    /* the packed fingerprints are zero padded already */
+    for (size_t i = 0; i < flat->count; i++) memcpy(ix->keys[i], flat->fingerprints[i], ORG_INDEX_KEY);
+    index_fill(ix);
+    return 1;
+}
+
+void org_index_free(OrgIndex *ix) {
+    if (!ix) return;
+    free(ix->keys);
+    free(ix->nodes);
+    free(ix->same_key);
+    free(ix->slots);
+    free(ix->by_first);
+    memset(ix, 0, sizeof(*ix));
+}
+
+long org_index_lookup(const OrgIndex *ix, const uint8_t key[ORG_INDEX_KEY]) {
+    if (!ix->slots) return -1;
+    uint32_t h = index_hash(key);
+    for (size_t s = h & ix->slot_mask; ix->slots[s]; s = (s + 1) & ix->slot_mask) {
+        uint64_t slot = ix->slots[s];
+        if ((uint32_t)(slot >> 32) != h) continue;
+        uint32_t i = (uint32_t)slot - 1;
+        if (memcmp(ix->keys[i], key, ORG_INDEX_KEY) == 0) return (long)i;
+    }
+    return -1;
+}
+
+Node *org_find_by_fingerprint(const OrgIndex *ix, const char *fingerprint) {
+    if (!ix->nodes) return NULL;
+    uint8_t key[ORG_INDEX_KEY];
+    index_key(key, fingerprint, strnlen(fingerprint, ORG_INDEX_KEY));
+    for (long i = org_index_lookup(ix, key); i >= 0; i = (long)ix->same_key[i] - 1) {
+        if (strcmp(ix->nodes[i]->fingerprint, fingerprint) == 0) return ix->nodes[i];
+    }
+    return NULL;
+}
+
+/* ---- Snapshots ----
+ * File = 64-byte header followed by the OrgFlat block exactly as laid out by
+ * flat_layout(). Everything inside the block is an offset, so the mapped
+ * file is used in place. Multi-byte fields are in host byte order; the
+ * byte_order marker rejects files from a host with the other one. */
+#define SNAPSHOT_MAGIC   "ORGSNAP"
+#define SNAPSHOT_VERSION 1u
+#define SNAPSHOT_BOM     0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t count;
+    uint64_t strings_len;
+    uint64_t block_len;
+    uint64_t checksum;
+    uint8_t reserved[16];
+} SnapshotHeader;
+
+/* FNV-1a over 64-bit words; block lengths are a multiple of 64. */
+static uint64_t block_checksum(const void *block, size_t len) {
+    const uint64_t *w = (const uint64_t *)block;
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len / sizeof(uint64_t); i++) {
+        h ^= w[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+int save_org_snapshot(const OrgFlat *flat, const char *path) {
+    SnapshotHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    hdr.version = SNAPSHOT_VERSION;
+    hdr.byte_order = SNAPSHOT_BOM;
+    hdr.count = flat->count;
+    hdr.strings_len = flat->strings_len;
+    hdr.block_len = flat->block_len;
+    hdr.checksum = block_checksum(flat->block, flat->block_len);
+
+    OutBuf ob;
+    if (!outbuf_open(&ob, path)) {
+        printf("Error opening file: %s\n", path);
+        return 0;
+    }
+    outbuf_put(&ob, (const char *)&hdr, sizeof(hdr));
+    if (flat->block_len) outbuf_put(&ob, (const char *)flat->block, flat->block_len);
+    if (!outbuf_close(&ob)) {
+        printf("Error writing file: %s\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+int load_org_snapshot(const char *path, OrgFlat *flat) {
+    memset(flat, 0, sizeof(*flat));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error opening file: %s\n", path);
+        return -1;
+    }
+
+    SnapshotHeader hdr;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(hdr) ||
+        read(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr) ||
+        memcmp(hdr.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        close(fd);
+        return 0;
+    }
+
+    size_t expect_len;
+    flat_layout(flat, (size_t)hdr.count, (size_t)hdr.strings_len, NULL, &expect_len);
+    if (hdr.version != SNAPSHOT_VERSION || hdr.byte_order != SNAPSHOT_BOM ||
+        hdr.block_len != expect_len || (uint64_t)sb.st_size != sizeof(hdr) + hdr.block_len) {
+        printf("Invalid snapshot: %s\n", path);
+        close(fd);
+        return -1;
+    }
+    if (hdr.count == 0) {
+        close(fd);
+        return 1;
+    }
+
+    void *map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Error mapping file: %s\n", path);
+        return -1;
+    }
+    char *block = (char *)map + sizeof(hdr);
+    if (block_checksum(block, (size_t)hdr.block_len) != hdr.checksum) {
+        printf("Invalid snapshot: %s\n", path);
+        munmap(map, (size_t)sb.st_size);
+        return -1;
+    }
+
+    flat_layout(flat, (size_t)hdr.count, (size_t)hdr.strings_len, block, &expect_len);
+    flat->block = block;
+    flat->block_len = expect_len;
+    flat->map = map;
+    flat->map_len = (size_t)sb.st_size;
+
+    /* every string offset must land inside the NUL-terminated pool */
+    int ok = flat->strings_len > 0 && flat->strings[flat->strings_len - 1] == '\0';
+    for (size_t i = 0; ok && i < flat->count; i++) {
+        ok = flat->first_off[i] < flat->strings_len && flat->second_off[i] < flat->strings_len &&
+             flat->fingerprint_off[i] < flat->strings_len && flat->position[i] < ORG_POS_COUNT;
+    }
+    if (!ok) {
+        printf("Invalid snapshot: %s\n", path);
+        org_flat_free(flat);
+        return -1;
+    }
+    return 1;
+}
+
+/* ---- N-ary hierarchy ---- */
+
+void org_hier_init(OrgHier *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void org_hier_free(OrgHier *h) {
+    if (!h) return;
+    free(h->parent);
+    free(h->level);
+    free(h->rank);
+    free(h->first_off);
+    free(h->second_off);
+    free(h->fingerprint_off);
+    free(h->position_off);
+    free(h->strings);
+    free(h->child_start);
+    free(h->child_list);
+    free(h->roots);
+    free(h->child_count);
+    org_hier_init(h);
+}
+
+static int grow_u32(uint32_t **arr, size_t cap) {
+    uint32_t *tmp = (uint32_t *)realloc(*arr, cap * sizeof(uint32_t));
+    if (!tmp) return 0;
+    *arr = tmp;
+    return 1;
+}
+
+/* Appends s (NUL included) to the string pool; returns its offset, or
+ * UINT32_MAX if the pool cannot take it. */
+static uint32_t hier_string(OrgHier *h, const char *s, size_t n) {
+    if (h->strings_len + n + 1 > h->strings_cap) {
+        size_t cap = h->strings_cap ? h->strings_cap * 2 : 4096;
+        while (cap < h->strings_len + n + 1) cap *= 2;
+        if (cap > UINT32_MAX) cap = UINT32_MAX;
+        if (h->strings_len + n + 1 > cap) return UINT32_MAX;
+        char *tmp = (char *)realloc(h->strings, cap);
+        if (!tmp) return UINT32_MAX;
+        h->strings = tmp;
+        h->strings_cap = cap;
+    }
+    uint32_t off = (uint32_t)h->strings_len;
+    memcpy(h->strings + off, s, n);
+    h->strings[off + n] = '\0';
+    h->strings_len += n + 1;
+    return off;
+}
+
+static uint32_t hier_add_views(OrgHier *h, uint32_t parent, StrView first, StrView second, StrView fingerprint,
+                               StrView position) {
+    if (h->count == h->cap) {
+        size_t cap = h->cap ? h->cap * 2 : 1024;
+        if (cap >= ORG_HIER_NONE) return ORG_HIER_NONE;
+        if (!grow_u32(&h->parent, cap) || !grow_u32(&h->level, cap) || !grow_u32(&h->rank, cap) ||
+            !grow_u32(&h->first_off, cap) || !grow_u32(&h->second_off, cap) ||
+            !grow_u32(&h->fingerprint_off, cap) || !grow_u32(&h->position_off, cap) ||
+            !grow_u32(&h->child_count, cap)) {
+            return ORG_HIER_NONE;
+        }
+        h->cap = cap;
+    }
+    size_t i = h->count;
+    h->first_off[i] = hier_string(h, first.p, first.n);
+    h->second_off[i] = hier_string(h, second.p, second.n);
+    h->fingerprint_off[i] = hier_string(h, fingerprint.p, fingerprint.n);
+    h->position_off[i] = hier_string(h, position.p, position.n);
+    if (h->first_off[i] == UINT32_MAX || h->second_off[i] == UINT32_MAX ||
+        h->fingerprint_off[i] == UINT32_MAX || h->position_off[i] == UINT32_MAX) {
+        return ORG_HIER_NONE;
+    }
+
+    if (parent >= i) parent = ORG_HIER_NONE;
+    h->parent[i] = parent;
+    h->level[i] = parent == ORG_HIER_NONE ? 0 : h->level[parent] + 1;
+    h->rank[i] = parent == ORG_HIER_NONE ? (uint32_t)h->root_count++ : h->child_count[parent]++;
+    h->child_count[i] = 0;
+    h->count++;
+    h->sealed = 0;
+    return (uint32_t)i;
+}
+
+static StrView str_view(const char *s) {
+    StrView v = { s, strlen(s) };
+    return v;
+}
+
+uint32_t org_hier_add(OrgHier *h, uint32_t parent, const char *first, const char *second,
+                      const char *fingerprint, const char *position) {
+    return hier_add_views(h, parent, str_view(first), str_view(second), str_view(fingerprint), str_view(position));
+}
+
+int org_hier_seal(OrgHier *h) {
+    free(h->child_start);
+    free(h->child_list);
+    free(h->roots);
+    size_t n = h->count;
+    h->child_start = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+    h->child_list = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+    h->roots = (uint32_t *)malloc((h->root_count ? h->root_count : 1) * sizeof(uint32_t));
+    if (!h->child_start || !h->child_list || !h->roots) return 0;
+
+    /* children are bucketed by parent in member order, so siblings stay in rank order */
+    uint32_t at = 0;
+    for (size_t i = 0; i < n; i++) {
+        h->child_start[i] = at;
+        at += h->child_count[i];
+    }
+    h->child_start[n] = at;
+    size_t roots = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t p = h->parent[i];
+        if (p == ORG_HIER_NONE) h->roots[roots++] = (uint32_t)i;
+        else h->child_list[h->child_start[p] + h->rank[i]] = (uint32_t)i;
+    }
+    h->sealed = 1;
+    return 1;
+}
+
+/* Fingerprint -> first member with it, for resolving Parent lines. */
+typedef struct {
+    uint32_t *slots;    /* member + 1, 0 = empty */
+    size_t mask;
+    size_t count;
+} HierFpMap;
+
+static uint64_t hier_fp_hash(const char *s, size_t n) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int fp_map_grow(HierFpMap *m, const OrgHier *h) {
+    size_t cap = m->slots ? (m->mask + 1) * 2 : 1024;
+    uint32_t *slots = (uint32_t *)calloc(cap, sizeof(uint32_t));
+    if (!slots) return 0;
+    for (size_t i = 0; m->slots && i <= m->mask; i++) {
+        if (!m->slots[i]) continue;
+        const char *fp = org_hier_fingerprint(h, m->slots[i] - 1);
+        size_t j = (size_t)hier_fp_hash(fp, strlen(fp)) & (cap - 1);
+        while (slots[j]) j = (j + 1) & (cap - 1);
+        slots[j] = m->slots[i];
+    }
+    free(m->slots);
+    m->slots = slots;
+    m->mask = cap - 1;
+    return 1;
+}
+
+/* Slot for fingerprint fp (n bytes): the one holding it, or the empty one it would go in. */
+static size_t fp_map_slot(const HierFpMap *m, const OrgHier *h, const char *fp, size_t n) {
+    size_t j = (size_t)hier_fp_hash(fp, n) & m->mask;
+    while (m->slots[j]) {
+        const char *k = org_hier_fingerprint(h, m->slots[j] - 1);
+        if (strncmp(k, fp, n) == 0 && k[n] == '\0') break;
+        j = (j + 1) & m->mask;
+    }
+    return j;
+}
+
+static int is_pos(StrView pos, const char *a, const char *b) {
+    size_t na = strlen(a), nb = strlen(b);
+    return (pos.n == na && memcmp(pos.p, a, na) == 0) || (pos.n == nb && memcmp(pos.p, b, nb) == 0);
+}
+
+int org_hier_from_buffer(const char *data, size_t len, OrgHier *h) {
+    org_hier_init(h);
+    HierFpMap map = { NULL, 0, 0 };
+    if (!fp_map_grow(&map, h)) {
+        printf("Memory allocation failed\n");
+        return 0;
+    }
+
+    uint32_t boss = ORG_HIER_NONE, left = ORG_HIER_NONE, right = ORG_HIER_NONE;
+    size_t at = 0;
+    StrView line;
+    int ok = 1;
+    STAT_TIMER_START(STAT_ORG_PARSE);
+    while (ok && next_line(data, len, &at, &line)) {
+        if (line.n == 0 || !starts_with(line, "First Name:")) continue;
+        StrView lines[4] = { line }, parent_line = { NULL, 0 };
+        if (!next_line(data, len, &at, &lines[1])) break;
+        if (!next_line(data, len, &at, &lines[2])) break;
+        if (!next_line(data, len, &at, &lines[3])) break;
+        size_t peek = at;
+        if (next_line(data, len, &peek, &parent_line) && starts_with(parent_line, "Parent:")) at = peek;
+        else parent_line.p = NULL;
+
+        static const char *const labels[4] = { "First Name:", "Second Name:", "Fingerprint:", "Position:" };
+        StrView v[4];
+        for (int k = 0; k < 4; k++) {
+            size_t skip = strlen(labels[k]);
+            StrView rest = { lines[k].p + (skip < lines[k].n ? skip : lines[k].n),
+                             skip < lines[k].n ? lines[k].n - skip : 0 };
+            v[k] = trim_view(rest);
+        }
+
+        uint32_t parent = ORG_HIER_NONE;
+        uint32_t *hand = NULL;
+        if (parent_line.p) {
+            StrView key = { parent_line.p + 7, parent_line.n - 7 };
+            key = trim_view(key);
+            size_t j = fp_map_slot(&map, h, key.p, key.n);
+            if (map.slots[j]) parent = map.slots[j] - 1;
+        } else if (is_pos(v[3], "Left Hand", "Left_Hand")) {
+            parent = boss;
+            hand = &left;
+        } else if (is_pos(v[3], "Right Hand", "Right_Hand")) {
+            parent = boss;
+            hand = &right;
+        } else if (is_pos(v[3], "Support_Left", "Support Left")) {
+            parent = left;
+        } else if (is_pos(v[3], "Support_Right", "Support Right")) {
+            parent = right;
+        }
+
+        uint32_t i = hier_add_views(h, parent, v[0], v[1], v[2], v[3]);
+        if (i == ORG_HIER_NONE) {
+            ok = 0;
+            break;
+        }
+        if (is_pos(v[3], "Boss", "Boss")) boss = i;
+        if (hand) *hand = i;
+        else if (is_pos(v[3], "Left Hand", "Left_Hand")) left = i;
+        else if (is_pos(v[3], "Right Hand", "Right_Hand")) right = i;
+
+        size_t j = fp_map_slot(&map, h, v[2].p, v[2].n);
+        if (!map.slots[j]) {
+            map.slots[j] = i + 1;
+            if (++map.count * 2 > map.mask + 1 && !fp_map_grow(&map, h)) ok = 0;
+        }
+    }
+    STAT_TIMER_STOP(STAT_ORG_PARSE);
+    STAT_COUNT(STAT_ORG_MEMBERS, h->count);
+    free(map.slots);
+
+    if (!ok || !org_hier_seal(h)) {
+        printf("Memory allocation failed\n");
+        org_hier_free(h);
+        return 0;
     }
+    return 1;
+}
 
-    free(org->boss);
-    free(org->left_hand);
-    free(org->right_hand);
+int org_hier_from_clean_file(const char *path, OrgHier *h) {
+    org_hier_init(h);
+    InputSpan span;
+    STAT_TIMER_START(STAT_ORG_READ);
+    int opened = span_open(&span, path);
+    STAT_TIMER_STOP(STAT_ORG_READ);
+    if (!opened) {
+        printf("Error opening file: %s\n", path);
+        return 0;
+    }
+    int ok = org_hier_from_buffer(span.data, span.len, h);
+    span_close(&span);
+    return ok;
+}
 
-    org->boss = NULL;
-    org->left_hand = NULL;
-    org->right_hand = NULL;
+size_t org_hier_preorder(const OrgHier *h, uint32_t *order) {
+    if (h->count == 0) return 0;
+    uint32_t *stack = (uint32_t *)malloc(h->count * sizeof(uint32_t));
+    if (!stack) return 0;
+    size_t top = 0, n = 0;
+    for (size_t r = h->root_count; r > 0; r--) stack[top++] = h->roots[r - 1];
+    while (top > 0) {
+        uint32_t i = stack[--top];
+        order[n++] = i;
+        /* children go on reversed so the first one comes off next */
+        for (uint32_t c = h->child_start[i + 1]; c > h->child_start[i]; c--) stack[top++] = h->child_list[c - 1];
+    }
+    free(stack);
+    return n;
+}
+
+size_t org_hier_level_order(const OrgHier *h, uint32_t *order) {
+    /* order doubles as the queue: each member's children are one contiguous copy */
+    size_t n = h->root_count;
+    if (n) memcpy(order, h->roots, n * sizeof(uint32_t));
+    for (size_t head = 0; head < n; head++) {
+        uint32_t i = order[head];
+        size_t kids = h->child_start[i + 1] - h->child_start[i];
+        if (kids) memcpy(order + n, h->child_list + h->child_start[i], kids * sizeof(uint32_t));
+        n += kids;
+    }
+    return n;
+}
+
+void print_hier_order(const OrgHier *h, const uint32_t *order, size_t n) {
+    OutBuf out;
+    fflush(stdout);
+    if (!outbuf_init_fd(&out, 1)) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    for (size_t k = 0; k < n; k++) {
+        size_t i = order[k];
+        outbuf_puts(&out, "First Name: ");
+        outbuf_puts(&out, org_hier_first(h, i));
+        outbuf_puts(&out, "\nSecond Name: ");
+        outbuf_puts(&out, org_hier_second(h, i));
+        outbuf_puts(&out, "\nFingerprint: ");
+        outbuf_puts(&out, org_hier_fingerprint(h, i));
+        outbuf_puts(&out, "\nPosition: ");
+        outbuf_puts(&out, org_hier_position(h, i));
+        outbuf_puts(&out, "\n\n");
+    }
+    outbuf_close(&out);
+}
+
+void print_hier(const OrgHier *h) {
+    if (!h || h->count == 0) return;
+    uint32_t *order = (uint32_t *)malloc(h->count * sizeof(uint32_t));
+    size_t n = order ? org_hier_preorder(h, order) : 0;
+    if (n) print_hier_order(h, order, n);
+    else printf("Memory allocation failed\n");
+    free(order);
+}
+
+void org_hier_roles(const OrgHier *h, OrgHierRoles *roles) {
+    roles->hier = h;
+    roles->boss = roles->left_hand = roles->right_hand = ORG_HIER_NONE;
+    for (size_t i = 0; i < h->count; i++) {
+        StrView pos = str_view(org_hier_position(h, i));
+        if (is_pos(pos, "Boss", "Boss")) roles->boss = (uint32_t)i;
+        else if (is_pos(pos, "Left Hand", "Left_Hand")) roles->left_hand = (uint32_t)i;
+        else if (is_pos(pos, "Right Hand", "Right_Hand")) roles->right_hand = (uint32_t)i;
+    }
+}
+
+uint32_t org_hier_next_support(const OrgHierRoles *roles, uint32_t hand, uint32_t after) {
+    const OrgHier *h = roles->hier;
+    if (hand == ORG_HIER_NONE || (hand != roles->left_hand && hand != roles->right_hand)) return ORG_HIER_NONE;
+    const char *a = hand == roles->left_hand ? "Support_Left" : "Support_Right";
+    const char *b = hand == roles->left_hand ? "Support Left" : "Support Right";
+    /* children sit in rank order, so the next one is right after after's rank */
+    uint32_t c = h->child_start[hand] + (after == ORG_HIER_NONE ? 0 : h->rank[after] + 1);
+    for (; c < h->child_start[hand + 1]; c++) {
+        uint32_t i = h->child_list[c];
+        if (is_pos(str_view(org_hier_position(h, i)), a, b)) return i;
+    }
+    return ORG_HIER_NONE;
+}
+
+size_t org_hier_role_order(const OrgHierRoles *roles, uint32_t *order) {
+    if (roles->boss == ORG_HIER_NONE) return 0;
+    size_t n = 0;
+    order[n++] = roles->boss;
+    const uint32_t hands[2] = { roles->left_hand, roles->right_hand };
+    for (int s = 0; s < 2; s++) {
+        if (hands[s] == ORG_HIER_NONE) continue;
+        order[n++] = hands[s];
+        for (uint32_t i = org_hier_next_support(roles, hands[s], ORG_HIER_NONE); i != ORG_HIER_NONE;
+             i = org_hier_next_support(roles, hands[s], i)) {
+            order[n++] = i;
+        }
+    }
+    return n;
 }
@@ -1,9 +1,14 @@
 #ifndef ORG_TREE_H
 #define ORG_TREE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
 #define MAX_FIELD 128
 #define MAX_POS   32
 
 typedef struct Node Node;
+struct CleanList;
 
 struct Node {
     char first[MAX_FIELD];
@@ -22,14 +27,220 @@ struct Node {
     Node *next;
 };
 
+typedef struct NodeSlab NodeSlab;
+
 typedef struct {
     Node *boss;
     Node *left_hand;
     Node *right_hand;
+
+    // Last node of each hand's support list (O(1) append)
+    Node *left_tail;
+    Node *right_tail;
+
+    // Slab allocator owning every node; free_org releases it in one sweep
+    NodeSlab *slabs;
 } Org;
 
 Org build_org_from_clean_file(const char *path);
+/* Same parser over clean-file text already in memory. */
+Org build_org_from_buffer(const char *data, size_t len);
+/* Same org straight from the cleaner's entries (a finished CleanList),
+ * without writing and re-parsing the clean file. */
+Org build_org_from_list(const struct CleanList *list);
 void print_tree_order(const Org *org);
 void free_org(Org *org);
 
+/* Compact, read-mostly view of an Org for scans. Entries are stored in print
+ * order (Boss, Left Hand, its supports, Right Hand, its supports) as parallel
+ * arrays in a single block: fingerprints are packed ORG_FP_WIDTH bytes apart
+ * (zero padded, truncated beyond that), names are offsets into one string
+ * pool and the position is a one-byte OrgPosition. */
+#define ORG_FP_WIDTH 16
+
+typedef enum {
+    ORG_POS_BOSS,
+    ORG_POS_LEFT_HAND,
+    ORG_POS_SUPPORT_LEFT,
+    ORG_POS_RIGHT_HAND,
+    ORG_POS_SUPPORT_RIGHT,
+    ORG_POS_COUNT
+} OrgPosition;
+
+typedef struct {
+    size_t count;
+    const char (*fingerprints)[ORG_FP_WIDTH];
+    const uint32_t *first_off;
+    const uint32_t *second_off;
+    const uint32_t *fingerprint_off;   // full fingerprint string
+    const uint8_t *position;
+    const char *strings;
+    size_t strings_len;
+
+    void *block;        // storage behind the arrays
+    size_t block_len;
+    void *map;          // snapshot mapping holding block, or NULL if heap
+    size_t map_len;
+} OrgFlat;
+
+/* Returns 0 on allocation failure. An Org without a Boss gives an empty view. */
+int org_flat_from_org(const Org *org, OrgFlat *flat);
+void org_flat_free(OrgFlat *flat);
+
+const char *org_flat_first(const OrgFlat *flat, size_t i);
+const char *org_flat_second(const OrgFlat *flat, size_t i);
+const char *org_flat_fingerprint(const OrgFlat *flat, size_t i);
+OrgPosition org_flat_position(const OrgFlat *flat, size_t i);
+/* Canonical spelling: "Boss", "Left Hand", "Support_Left", ... */
+const char *org_position_name(OrgPosition pos);
+
+/* Same output as print_tree_order, with positions in canonical spelling. */
+void print_tree_order_flat(const OrgFlat *flat);
+
+/* Binary snapshot of an OrgFlat: versioned, checksummed header + the block
+ * as-is. Loading maps the file and points the view into it, with no parsing
+ * and no per-node allocation; org_flat_free() unmaps it.
+ * save: returns 1 on success, 0 on failure (message printed).
+ * load: returns 1 on success, 0 if path is not a snapshot at all, -1 if it
+ * cannot be opened or is a damaged / incompatible snapshot (message printed). */
+int save_org_snapshot(const OrgFlat *flat, const char *path);
+int load_org_snapshot(const char *path, OrgFlat *flat);
+
+/* Hash index on the fingerprint bytes a cipher covers (the first
+ * ORG_INDEX_KEY, zero padded), built alongside an Org or an OrgFlat.
+ * Members are numbered in print / search order and a key shared by several
+ * members finds the first of them. by_first lists the members bucketed by
+ * first fingerprint byte, each bucket in order, so a scan can skip every
+ * member whose first byte rules it out. */
+#define ORG_INDEX_KEY 9
+
+typedef struct {
+    size_t count;
+    uint8_t (*keys)[ORG_INDEX_KEY];     // per member
+    Node **nodes;                       // per member; NULL for an OrgFlat index
+    uint32_t *same_key;                 // per member: next member with its key + 1, 0 = none; Node index only
+    uint64_t *slots;                    // hash << 32 | (member + 1); 0 = empty
+    size_t slot_mask;
+    uint32_t by_first_start[257];       // bucket b is by_first[start[b] .. start[b + 1])
+    uint32_t *by_first;
+} OrgIndex;
+
+/* Both return 0 on allocation failure. */
+int org_index_build(const Org *org, OrgIndex *ix);
+int org_index_build_flat(const OrgFlat *flat, OrgIndex *ix);
+void org_index_free(OrgIndex *ix);
+
+/* Member number of the first member with this key, or -1. */
+long org_index_lookup(const OrgIndex *ix, const uint8_t key[ORG_INDEX_KEY]);
+/* First node whose whole fingerprint equals fingerprint, or NULL; always
+ * NULL for an OrgFlat index. Members that only share the key are skipped. */
+Node *org_find_by_fingerprint(const OrgIndex *ix, const char *fingerprint);
+
+/* General N-ary hierarchy in flat arrays, for orgs of any depth and size.
+ * Members are numbered in the order they were added and a parent is always
+ * added before its children, so parent[i] < i. After org_hier_seal() the
+ * children of each member sit next to each other in CSR form, in the order
+ * they were added, and the traversals below are plain array walks.
+ *
+ * Clean files map onto it like this: a record may carry a "Parent:
+ * <fingerprint>" line after Position, naming an earlier member. Without one
+ * the three-role rules apply: a Boss is a root, a Hand hangs under the last
+ * Boss and a support under the last Hand of its side. Nothing is dropped:
+ * a record those rules cannot place (an unknown position, a support before
+ * any Hand, a Parent not seen before) becomes a root. */
+#define ORG_HIER_NONE UINT32_MAX
+
+typedef struct {
+    size_t count;
+    uint32_t *parent;           // ORG_HIER_NONE for a root
+    uint32_t *level;            // depth, 0 for a root
+    uint32_t *rank;             // place among its siblings
+    uint32_t *first_off;        // names, fingerprint and position: offsets into strings
+    uint32_t *second_off;
+    uint32_t *fingerprint_off;
+    uint32_t *position_off;
+    char *strings;
+    size_t strings_len;
+
+    // CSR, valid once sealed: the children of i are
+    // child_list[child_start[i] .. child_start[i + 1]), the roots roots[0 .. root_count)
+    uint32_t *child_start;
+    uint32_t *child_list;
+    uint32_t *roots;
+    size_t root_count;
+    int sealed;
+
+    // build state
+    uint32_t *child_count;
+    size_t cap;
+    size_t strings_cap;
+} OrgHier;
+
+void org_hier_init(OrgHier *h);
+void org_hier_free(OrgHier *h);
+/* Appends a member under parent (an earlier member or ORG_HIER_NONE) and
+ * returns its number, or ORG_HIER_NONE on allocation failure. Unseals h. */
+uint32_t org_hier_add(OrgHier *h, uint32_t parent, const char *first, const char *second,
+                      const char *fingerprint, const char *position);
+/* Builds the CSR arrays. Returns 0 on allocation failure. */
+int org_hier_seal(OrgHier *h);
+
+/* Parses clean-file text (see above) and seals the result. Both return 0 on
+ * failure (message printed). */
+int org_hier_from_buffer(const char *data, size_t len, OrgHier *h);
+int org_hier_from_clean_file(const char *path, OrgHier *h);
+
+static inline const char *org_hier_first(const OrgHier *h, size_t i) {
+    return h->strings + h->first_off[i];
+}
+static inline const char *org_hier_second(const OrgHier *h, size_t i) {
+    return h->strings + h->second_off[i];
+}
+static inline const char *org_hier_fingerprint(const OrgHier *h, size_t i) {
+    return h->strings + h->fingerprint_off[i];
+}
+static inline const char *org_hier_position(const OrgHier *h, size_t i) {
+    return h->strings + h->position_off[i];
+}
+
+/* Iterative traversals of a sealed hierarchy. They write every member
+ * number once into order (room for h->count) and return how many, or 0 on
+ * allocation failure. Pre-order takes each root's tree in turn, a member
+ * before its children's subtrees; level order lists the roots, then every
+ * member one level down, and so on. Siblings come in the order they were
+ * added (print_tree_order instead always puts the Left Hand first). */
+size_t org_hier_preorder(const OrgHier *h, uint32_t *order);
+size_t org_hier_level_order(const OrgHier *h, uint32_t *order);
+
+/* Prints the members in order[0 .. n) in the print_tree_order format, in
+ * large buffered writes to stdout. */
+void print_hier_order(const OrgHier *h, const uint32_t *order, size_t n);
+/* Pre-order print of the whole hierarchy. */
+void print_hier(const OrgHier *h);
+
+/* The three roles read straight off a sealed hierarchy, nothing copied:
+ * the last Boss and the last Left and Right Hand (ORG_HIER_NONE if there is
+ * none), each Hand's supports being its children with that side's support
+ * position, in the order they were added. For a clean file without Parent
+ * lines this is the Org build_org_from_buffer() builds. Parent lines can
+ * move members under another member; the text parser ignores them, so
+ * there the two differ. */
+typedef struct {
+    const OrgHier *hier;
+    uint32_t boss;
+    uint32_t left_hand;
+    uint32_t right_hand;
+} OrgHierRoles;
+
+void org_hier_roles(const OrgHier *h, OrgHierRoles *roles);
+/* Support of hand after member after (ORG_HIER_NONE: the first one), or
+ * ORG_HIER_NONE when there are no more. hand is roles->left_hand or
+ * roles->right_hand. */
+uint32_t org_hier_next_support(const OrgHierRoles *roles, uint32_t hand, uint32_t after);
+/* Writes the roles in print_tree_order order (Boss, Left Hand, its
+ * supports, Right Hand, its supports) into order, room for the hierarchy's
+ * count, and returns how many; 0 without a Boss. print_hier_order() then
+ * prints what print_tree_order() does, with values never truncated. */
+size_t org_hier_role_order(const OrgHierRoles *roles, uint32_t *order);
+
 #endif // ORG_TREE_H
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "cleaner.h"
+#include "org_tree.h"
+#include "org_search.h"
+#include "cipher_reader.h"
+#include "io_buf.h"
+#include "stats.h"
+
+/* ex1 and ex2 in one process: the dump is cleaned into memory, the org is
+ * built from those entries and every cipher of the cipher file is searched
+ * like ex2 does, without writing and re-reading a clean file in between.
+ * The output matches ex2 on the clean file ex1 would write (--stream for a
+ * file holding several ciphers). */
+
+#define CIPHER_BATCH 4096
+
+/* Cleans the dump and builds the searchable org, writing the clean file too
+ * when clean_path is set. Returns 1 if there is an org (with a Boss). */
+static int build_org(const char *dump_path, int threads, const char *clean_path, OrgFlat *org, OrgIndex *ix) {
+    memset(org, 0, sizeof(*org));
+    memset(ix, 0, sizeof(*ix));
+
+    CleanList list;
+    if (!clean_file_entries(dump_path, threads, &list)) return 0;
+    if (clean_path && !clean_list_write(&list, clean_path)) {
+        clean_list_free(&list);
+        return 0;
+    }
+    Org tree = build_org_from_list(&list);
+    clean_list_free(&list);
+    if (!tree.boss) {
+        free_org(&tree);
+        return 0;
+    }
+
+    STAT_TIMER_START(STAT_ORG_INDEX);
+    int ok = org_flat_from_org(&tree, org);
+    free_org(&tree);
+    ok = ok && org_index_build_flat(org, ix);
+    STAT_TIMER_STOP(STAT_ORG_INDEX);
+    if (!ok) printf("Memory allocation failed\n");
+    return ok;
+}
+
+/* One result line per cipher, in file order. Returns 0 if the cipher file
+ * cannot be opened. */
+static int search_ciphers(const OrgFlat *org, const OrgIndex *ix, const char *path, CipherFormat fmt, int s) {
+    CipherReader r;
+    if (!cipher_reader_open(&r, path, fmt)) {
+        printf("Error opening file: %s\n", path);
+        return 0;
+    }
+    uint8_t (*ciphers)[CIPHER_LEN] = (uint8_t (*)[CIPHER_LEN])malloc(CIPHER_BATCH * CIPHER_LEN);
+    OutBuf out;
+    if (!ciphers || !outbuf_init_fd(&out, 1)) {
+        printf("Memory allocation failed\n");
+        free(ciphers);
+        cipher_reader_close(&r);
+        return 0;
+    }
+    mask_match_init();
+
+    char line[SOLUTION_LINE_MAX];
+    size_t got;
+    do {
+        STAT_TIMER_START(STAT_CIPHER_READ);
+        got = cipher_reader_next(&r, ciphers, CIPHER_BATCH);
+        STAT_TIMER_STOP(STAT_CIPHER_READ);
+        for (size_t i = 0; i < got; i++) {
+            STAT_TIMER_START(STAT_MASK_SEARCH);
+            Solution sol = find_match_in_org(org, ix, ciphers[i], s);
+            STAT_TIMER_STOP(STAT_MASK_SEARCH);
+            STAT_COUNT(STAT_CIPHERS, 1);
+            if (sol.node >= 0) STAT_COUNT(STAT_MATCHES, 1);
+            STAT_TIMER_START(STAT_FORMAT);
+            outbuf_put(&out, line, format_solution(line, sizeof(line), org, &sol));
+            STAT_TIMER_STOP(STAT_FORMAT);
+        }
+    } while (got == CIPHER_BATCH);
+    if (r.error) {
+        snprintf(line, sizeof(line), "Invalid cipher record %zu in %s\n", r.records, path);
+        outbuf_puts(&out, line);
+    }
+    outbuf_close(&out);
+    free(ciphers);
+    cipher_reader_close(&r);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    /* --stats anywhere: per-stage breakdown on stderr at exit (needs a HW_STATS build) */
+    stats_take_flag(&argc, argv, "pipeline");
+    const char *prog = argv[0];
+    const char *clean_path = NULL;
+    int threads = 1, bad = 0;
+    CipherFormat fmt = CIPHER_FMT_AUTO;
+    while (argc > 2 && argv[1][0] == '-' && argv[1][1] != '\0') {
+        const char *opt = argv[1];
+        const char *val = argv[2];
+        if (strcmp(opt, "-j") == 0) threads = atoi(val);
+        else if (strcmp(opt, "--clean") == 0) clean_path = val;
+        else if (strcmp(opt, "--format") == 0) bad |= !cipher_format_parse(val, &fmt);
+        else break;
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc != 4 || threads < 1 || bad) {
+        printf("Usage: %s [-j threads] [--clean <output_clean.txt>] [--format auto|bits|hex|binary] "
+               "<input_corrupted.txt> <cipher_file|-> <mask_start_s>\n", prog);
+        printf("       --stats: per-stage breakdown on stderr (HW_STATS builds)\n");
+        return 0;
+    }
+
+    OrgFlat org;
+    OrgIndex ix;
+    if (build_org(argv[1], threads, clean_path, &org, &ix)) search_ciphers(&org, &ix, argv[2], fmt, atoi(argv[3]));
+    org_index_free(&ix);
+    org_flat_free(&org);
+    return 0;
+}
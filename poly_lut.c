@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "poly_lut.h"
+#include "fixed_point.h"
+#include "io_buf.h"
+
+#define LUT_BLOCK 4096      /* inputs generated per batch call */
+
+typedef struct {
+    const PolyLut *lut;
+    int16_t *y;
+    size_t from, to;        /* table indices */
+} LutJob;
+
+static void *lut_worker(void *arg) {
+    LutJob *job = (LutJob *)arg;
+    int16_t x[LUT_BLOCK];
+    for (size_t i = job->from; i < job->to; i += LUT_BLOCK) {
+        size_t n = job->to - i < LUT_BLOCK ? job->to - i : LUT_BLOCK;
+        for (size_t k = 0; k < n; k++) x[k] = (int16_t)(uint16_t)(i + k);
+        eval_poly_fixed_batch(x, job->y + i, n, job->lut->a, job->lut->b, job->lut->c, job->lut->q);
+    }
+    return NULL;
+}
+
+int poly_lut_build(PolyLut *lut, int16_t a, int16_t b, int16_t c, int16_t q, int threads) {
+    memset(lut, 0, sizeof(*lut));
+    lut->a = a;
+    lut->b = b;
+    lut->c = c;
+    lut->q = q;
+    int16_t *y = (int16_t *)aligned_alloc(64, POLY_LUT_SIZE * sizeof(int16_t));
+    if (!y) return 0;
+
+    if (threads < 1) threads = 1;
+    if (threads > 16) threads = 16;
+    LutJob jobs[16];
+    pthread_t tids[16];
+    size_t per = (POLY_LUT_SIZE / (size_t)threads + LUT_BLOCK - 1) / LUT_BLOCK * LUT_BLOCK;
+    for (int t = 0; t < threads; t++) {
+        jobs[t].lut = lut;
+        jobs[t].y = y;
+        jobs[t].from = per * (size_t)t < POLY_LUT_SIZE ? per * (size_t)t : POLY_LUT_SIZE;
+        jobs[t].to = per * (size_t)(t + 1) < POLY_LUT_SIZE ? per * (size_t)(t + 1) : POLY_LUT_SIZE;
+    }
+
+    eval_poly_fixed_init();
+    int started = 1;
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, lut_worker, &jobs[t]) != 0) break;
+        started++;
+    }
+    lut_worker(&jobs[0]);
+    for (int t = 1; t < started; t++) pthread_join(tids[t], NULL);
+    /* ranges whose thread could not be started */
+    for (int t = started; t < threads; t++) lut_worker(&jobs[t]);
+
+    lut->y = y;
+    lut->block = y;
+    return 1;
+}
+
+void poly_lut_free(PolyLut *lut) {
+    if (!lut) return;
+    if (lut->map) munmap(lut->map, lut->map_len);
+    else free(lut->block);
+    memset(lut, 0, sizeof(*lut));
+}
+
+void poly_lut_map(const PolyLut *lut, const int16_t *x, int16_t *y, size_t n) {
+    const int16_t *t = lut->y;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int16_t y0 = t[(uint16_t)x[i]];
+        int16_t y1 = t[(uint16_t)x[i + 1]];
+        int16_t y2 = t[(uint16_t)x[i + 2]];
+        int16_t y3 = t[(uint16_t)x[i + 3]];
+        y[i] = y0;
+        y[i + 1] = y1;
+        y[i + 2] = y2;
+        y[i + 3] = y3;
+    }
+    for (; i < n; i++) y[i] = t[(uint16_t)x[i]];
+}
+
+/* ---- Table files ----
+ * Same scheme as org snapshots: fixed header, payload used in place. */
+#define LUT_MAGIC   "POLYLUT"
+#define LUT_VERSION 1u
+#define LUT_BOM     0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int16_t a, b, c, q;
+    uint64_t entries;
+    uint64_t checksum;
+    uint8_t reserved[24];
+} LutHeader;
+
+/* FNV-1a over 64-bit words. */
+static uint64_t lut_checksum(const void *data, size_t len) {
+    const uint64_t *w = (const uint64_t *)data;
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len / sizeof(uint64_t); i++) {
+        h ^= w[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+int poly_lut_save(const PolyLut *lut, const char *path) {
+    const size_t len = POLY_LUT_SIZE * sizeof(int16_t);
+    LutHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, LUT_MAGIC, sizeof(LUT_MAGIC));
+    hdr.version = LUT_VERSION;
+    hdr.byte_order = LUT_BOM;
+    hdr.a = lut->a;
+    hdr.b = lut->b;
+    hdr.c = lut->c;
+    hdr.q = lut->q;
+    hdr.entries = POLY_LUT_SIZE;
+    hdr.checksum = lut_checksum(lut->y, len);
+
+    OutBuf ob;
+    if (!outbuf_open(&ob, path)) {
+        printf("Error opening file: %s\n", path);
+        return 0;
+    }
+    outbuf_put(&ob, (const char *)&hdr, sizeof(hdr));
+    outbuf_put(&ob, (const char *)lut->y, len);
+    if (!outbuf_close(&ob)) {
+        printf("Error writing file: %s\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+int poly_lut_load(const char *path, PolyLut *lut) {
+    const size_t len = POLY_LUT_SIZE * sizeof(int16_t);
+    memset(lut, 0, sizeof(*lut));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error opening file: %s\n", path);
+        return -1;
+    }
+
+    LutHeader hdr;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(hdr) ||
+        read(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr) ||
+        memcmp(hdr.magic, LUT_MAGIC, sizeof(LUT_MAGIC)) != 0) {
+        close(fd);
+        return 0;
+    }
+    if (hdr.version != LUT_VERSION || hdr.byte_order != LUT_BOM || hdr.entries != POLY_LUT_SIZE ||
+        (size_t)sb.st_size != sizeof(hdr) + len) {
+        printf("Invalid table file: %s\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Error mapping file: %s\n", path);
+        return -1;
+    }
+    const int16_t *y = (const int16_t *)((const char *)map + sizeof(hdr));
+    if (lut_checksum(y, len) != hdr.checksum) {
+        printf("Invalid table file: %s\n", path);
+        munmap(map, (size_t)sb.st_size);
+        return -1;
+    }
+
+    lut->a = hdr.a;
+    lut->b = hdr.b;
+    lut->c = hdr.c;
+    lut->q = hdr.q;
+    lut->y = y;
+    lut->map = map;
+    lut->map_len = (size_t)sb.st_size;
+    return 1;
+}
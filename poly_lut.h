@@ -0,0 +1,39 @@
+#ifndef POLY_LUT_H
+#define POLY_LUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Every output of y = a*x^2 - b*x + c (as eval_poly_fixed_batch computes it)
+ * for one set of coefficients, indexed by the raw x as uint16_t: 128 KB that
+ * turn each later evaluation into one load. */
+#define POLY_LUT_SIZE 65536
+
+typedef struct {
+    int16_t a, b, c, q;
+    const int16_t *y;       // POLY_LUT_SIZE outputs
+    void *block;            // heap storage behind y, or NULL if mapped
+    void *map;              // table file mapping holding y, or NULL
+    size_t map_len;
+} PolyLut;
+
+/* Fills the table using up to threads threads. Returns 0 on allocation failure. */
+int poly_lut_build(PolyLut *lut, int16_t a, int16_t b, int16_t c, int16_t q, int threads);
+void poly_lut_free(PolyLut *lut);
+
+static inline int16_t poly_lut_eval(const PolyLut *lut, int16_t x) {
+    return lut->y[(uint16_t)x];
+}
+
+/* Maps every x[i] through the table into y[i] (x and y may be the same). */
+void poly_lut_map(const PolyLut *lut, const int16_t *x, int16_t *y, size_t n);
+
+/* Table file: versioned, checksummed 64-byte header with the coefficients,
+ * then the outputs as-is; loading maps it and points y into the mapping.
+ * save: returns 1 on success, 0 on failure (message printed).
+ * load: returns 1 on success, 0 if path is not a table file at all, -1 if it
+ * cannot be opened or is damaged / incompatible (message printed). */
+int poly_lut_save(const PolyLut *lut, const char *path);
+int poly_lut_load(const char *path, PolyLut *lut);
+
+#endif // POLY_LUT_H
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stats.h"
+
+static const char *report_tool;
+
+static void report_at_exit(void) {
+    fflush(stdout);
+    stats_report(report_tool);
+}
+
+int stats_take_flag(int *argc, char **argv, const char *tool) {
+    int found = 0, out = 1;
+    for (int i = 1; i < *argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) found = 1;
+        else argv[out++] = argv[i];
+    }
+    argv[out] = NULL;
+    *argc = out;
+    if (found) {
+        report_tool = tool;
+        atexit(report_at_exit);
+    }
+    return found;
+}
+
+#ifdef HW_STATS
+
+StatsData hw_stats;
+
+static const char *const timer_names[STAT_TIMER_COUNT] = {
+    "read", "filter", "label_scan", "record_cut", "dedup", "order", "write",
+    "org_read", "org_parse", "org_index", "cipher_read", "mask_search",
+    "poly_eval", "format",
+};
+
+static const char *const counter_names[STAT_COUNTER_COUNT] = {
+    "bytes_in", "bytes_dropped", "records", "duplicates", "entries_written",
+    "org_members", "unknown_freed", "ciphers", "masks_tested", "nodes_tested",
+    "matches", "samples",
+};
+
+static uint64_t start_cycles;
+static struct timespec start_time;
+
+/* Runs before main, so the wall clock covers the whole process. */
+__attribute__((constructor))
+static void stats_start(void) {
+    start_cycles = stats_cycles();
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+void stats_report(const char *tool) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t wall_cycles = stats_cycles() - start_cycles;
+    double wall_ms = (double)(now.tv_sec - start_time.tv_sec) * 1e3 +
+                     (double)(now.tv_nsec - start_time.tv_nsec) / 1e6;
+    /* counter ticks per millisecond over this run */
+    double per_ms = wall_ms > 0 ? (double)wall_cycles / wall_ms : 1.0;
+
+    fprintf(stderr, "%s stats: wall %.3f ms (%.1f Mcycles)\n", tool, wall_ms, (double)wall_cycles / 1e6);
+    fprintf(stderr, "  %-12s %10s %12s %10s %7s\n", "stage", "calls", "Mcycles", "ms", "share");
+    uint64_t total = 0;
+    for (int t = 0; t < STAT_TIMER_COUNT; t++) {
+        if (!hw_stats.calls[t]) continue;
+        uint64_t c = hw_stats.cycles[t];
+        total += c;
+        fprintf(stderr, "  %-12s %10llu %12.3f %10.3f %6.1f%%\n", timer_names[t],
+                (unsigned long long)hw_stats.calls[t], (double)c / 1e6, (double)c / per_ms,
+                wall_cycles ? 100.0 * (double)c / (double)wall_cycles : 0.0);
+    }
+    /* threaded stages can add up to more than the wall time */
+    double other = (double)wall_cycles - (double)total;
+    if (other > 0) {
+        fprintf(stderr, "  %-12s %10s %12.3f %10.3f %6.1f%%\n", "other", "-", other / 1e6, other / per_ms,
+                100.0 * other / (double)wall_cycles);
+    }
+    for (int c = 0; c < STAT_COUNTER_COUNT; c++) {
+        if (!hw_stats.counters[c]) continue;
+        fprintf(stderr, "  %-16s %llu\n", counter_names[c], (unsigned long long)hw_stats.counters[c]);
+    }
+}
+
+#else
+
+void stats_report(const char *tool) {
+    fprintf(stderr, "%s stats: not compiled in (build with -DHW_STATS, e.g. make STATS=1)\n", tool);
+}
+
+#endif
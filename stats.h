@@ -0,0 +1,100 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+/* Hot-path instrumentation: cycle-counter timers around each stage and
+ * event counters, reported per stage by --stats. Compiled out unless the
+ * build defines HW_STATS (make STATS=1); otherwise the macros below expand
+ * to nothing and their arguments are never evaluated.
+ *
+ * Timers cover disjoint leaf regions, so their shares add up to the time
+ * accounted for; the report also shows the wall time of the run. Timers and
+ * counters may be hit from several threads: time is summed across them. */
+
+typedef enum {
+    STAT_READ,          /* input chunks read */
+    STAT_FILTER,        /* corruption / whitespace filter */
+    STAT_LABEL_SCAN,    /* label tokenizer */
+    STAT_RECORD_CUT,    /* values copied out of the cleaned stream */
+    STAT_DEDUP,         /* fingerprint set */
+    STAT_ORDER,         /* position ordering, held back and spilled entries */
+    STAT_WRITE,         /* final output flush */
+    STAT_ORG_READ,      /* clean file / snapshot loaded */
+    STAT_ORG_PARSE,     /* clean file or entries turned into nodes */
+    STAT_ORG_INDEX,     /* flat view and fingerprint index built */
+    STAT_CIPHER_READ,   /* cipher files / streams parsed */
+    STAT_MASK_SEARCH,   /* mask / key search */
+    STAT_POLY_EVAL,     /* polynomial evaluation or table build */
+    STAT_FORMAT,        /* results formatted */
+    STAT_TIMER_COUNT
+} StatTimer;
+
+typedef enum {
+    STAT_BYTES_IN,          /* input bytes filtered */
+    STAT_BYTES_DROPPED,     /* dropped as corruption or whitespace */
+    STAT_RECORDS,           /* records cut from the cleaned stream */
+    STAT_DUPLICATES,        /* records whose fingerprint was already seen */
+    STAT_ENTRIES_WRITTEN,   /* entries written to the clean file */
+    STAT_ORG_MEMBERS,       /* records read into an org */
+    STAT_UNKNOWN_FREED,     /* of those, unknown positions freed */
+    STAT_CIPHERS,           /* ciphers searched */
+    STAT_MASKS_TESTED,      /* masks tried, one per index probe or kernel lane */
+    STAT_NODES_TESTED,      /* members run through the mask tests */
+    STAT_MATCHES,           /* ciphers that found a member */
+    STAT_SAMPLES,           /* polynomial inputs evaluated */
+    STAT_COUNTER_COUNT
+} StatCounter;
+
+#ifdef HW_STATS
+
+typedef struct {
+    uint64_t cycles[STAT_TIMER_COUNT];
+    uint64_t calls[STAT_TIMER_COUNT];
+    uint64_t counters[STAT_COUNTER_COUNT];
+} StatsData;
+
+extern StatsData hw_stats;
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t stats_cycles(void) {
+    return __rdtsc();
+}
+#else
+#include <time.h>
+/* no cycle counter: nanoseconds, reported as such */
+static inline uint64_t stats_cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define STAT_TIMER_START(t) uint64_t stat_t0_##t = stats_cycles()
+#define STAT_TIMER_STOP(t)                                                        \
+    do {                                                                          \
+        __atomic_fetch_add(&hw_stats.cycles[t], stats_cycles() - stat_t0_##t,     \
+                           __ATOMIC_RELAXED);                                     \
+        __atomic_fetch_add(&hw_stats.calls[t], 1, __ATOMIC_RELAXED);              \
+    } while (0)
+#define STAT_COUNT(c, n) __atomic_fetch_add(&hw_stats.counters[c], (uint64_t)(n), __ATOMIC_RELAXED)
+
+#else
+
+#define STAT_TIMER_START(t) ((void)0)
+#define STAT_TIMER_STOP(t) ((void)0)
+/* sizeof keeps n unevaluated but still counts a local tally as used */
+#define STAT_COUNT(c, n) ((void)sizeof(n))
+
+#endif
+
+/* Removes every "--stats" from argv (argc updated). If there was one,
+ * stats_report(tool) runs when the process exits and 1 is returned. */
+int stats_take_flag(int *argc, char **argv, const char *tool);
+
+/* Per-stage breakdown of everything recorded since the process started, on
+ * stderr. Without HW_STATS it says so instead. */
+void stats_report(const char *tool);
+
+#endif // STATS_H
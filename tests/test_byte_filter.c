@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "byte_filter.h"
+#include "tests/test_rng.h"
+
+/* Every byte_filter kernel this CPU can run against byte_filter_scalar on
+ * random buffers: each length 0..64 and longer ones, at every source
+ * alignment within a vector, copied out and in place. */
+
+#define MAX_LEN 600
+#define ALIGNS 32
+
+/* Mostly bytes the filter has to tell apart: corruption characters,
+ * whitespace and its neighbours, plain text, and any byte at all. */
+static void fill(char *p, size_t n, unsigned drop_pct) {
+    static const char special[] = "#?!@&$ \t\n\v\f\r\b\x0e\x1f\x7f\x80\xff";
+    for (size_t i = 0; i < n; i++) {
+        unsigned r = (unsigned)(rng_next() >> 33) % 100;
+        if (r < drop_pct) p[i] = special[rng_next() % (sizeof(special) - 1)];
+        else if (r < 90) p[i] = (char)('!' + rng_next() % 94);
+        else p[i] = (char)(rng_next() & 0xFF);
+    }
+}
+
+static int check(const char *kernel, const char *src, size_t n, size_t align) {
+    static char want[MAX_LEN + BYTE_FILTER_SLACK];
+    static char got[MAX_LEN + ALIGNS + BYTE_FILTER_SLACK];
+    static char inplace[MAX_LEN + ALIGNS + BYTE_FILTER_SLACK];
+    size_t want_len = byte_filter_scalar(want, src, n);
+
+    size_t got_len = byte_filter(got, src, n);
+    if (got_len != want_len || memcmp(got, want, want_len) != 0) {
+        printf("FAIL %s: length %zu, alignment %zu: kept %zu bytes, scalar kept %zu\n", kernel, n, align, got_len,
+               want_len);
+        return 0;
+    }
+    memcpy(inplace + align, src, n);
+    got_len = byte_filter(inplace + align, inplace + align, n);
+    if (got_len != want_len || memcmp(inplace + align, want, want_len) != 0) {
+        printf("FAIL %s in place: length %zu, alignment %zu\n", kernel, n, align);
+        return 0;
+    }
+    return 1;
+}
+
+int main(void) {
+    rng_seed(0x9E3779B97F4A7C15ULL);
+    static const char *const kernels[] = { "scalar", "sse2", "avx2" };
+    static char buf[MAX_LEN + ALIGNS];
+    int ran = 0;
+    size_t cases = 0;
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!byte_filter_use(kernels[k])) {
+            printf("byte_filter: %s not available, skipped\n", kernels[k]);
+            continue;
+        }
+        ran++;
+        for (size_t n = 0; n <= MAX_LEN; n += n < 64 ? 1 : 37) {
+            for (size_t align = 0; align < ALIGNS; align++) {
+                /* none dropped, some, and most, to hit every store path */
+                static const unsigned drop[] = { 0, 15, 60 };
+                for (size_t d = 0; d < sizeof(drop) / sizeof(drop[0]); d++) {
+                    fill(buf + align, n, drop[d]);
+                    if (!check(kernels[k], buf + align, n, align)) return 1;
+                    cases++;
+                }
+            }
+        }
+    }
+    printf("byte_filter: %zu cases ok over %d kernels\n", cases, ran);
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fixed_q.h"
+#include "tests/test_rng.h"
+
+/* fixed_q.h against exact arithmetic: every fx8 / fx16 / fx32 operation and
+ * the q-pinned types over edge values and random ones, for each q from -2
+ * to past 2 * bits. Horner is checked against a sign-magnitude bignum, so
+ * overflowing accumulators are covered too. */
+
+#define BIG_LIMBS 40
+
+/* |v| in 32-bit limbs, low first, and its sign */
+typedef struct {
+    uint32_t mag[BIG_LIMBS];
+    int neg;
+} Big;
+
+static void big_set(Big *b, int64_t v) {
+    memset(b, 0, sizeof(*b));
+    uint64_t m = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    b->mag[0] = (uint32_t)m;
+    b->mag[1] = (uint32_t)(m >> 32);
+    b->neg = v < 0;
+}
+
+static int big_is_zero(const Big *b) {
+    for (int i = 0; i < BIG_LIMBS; i++) {
+        if (b->mag[i]) return 0;
+    }
+    return 1;
+}
+
+/* |a| vs |b| */
+static int big_cmp_mag(const Big *a, const Big *b) {
+    for (int i = BIG_LIMBS - 1; i >= 0; i--) {
+        if (a->mag[i] != b->mag[i]) return a->mag[i] < b->mag[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/* b *= v; returns 0 if the magnitude outgrows BIG_LIMBS */
+static int big_mul(Big *b, int64_t v) {
+    uint64_t m = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    uint32_t lo = (uint32_t)m, hi = (uint32_t)(m >> 32);
+    uint32_t out[BIG_LIMBS + 2] = { 0 };
+    for (int i = 0; i < BIG_LIMBS; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 2; j++) {
+            uint64_t t = (uint64_t)b->mag[i] * (j ? hi : lo) + out[i + j] + carry;
+            out[i + j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        for (int k = i + 2; carry; k++) {
+            uint64_t t = (uint64_t)out[k] + carry;
+            out[k] = (uint32_t)t;
+            carry = t >> 32;
+        }
+    }
+    if (out[BIG_LIMBS] || out[BIG_LIMBS + 1]) return 0;
+    memcpy(b->mag, out, sizeof(b->mag));
+    b->neg = !big_is_zero(b) && (b->neg != (v < 0));
+    return 1;
+}
+
+/* b = b / 2^q truncated toward zero (a magnitude shift); q < 0 gives 0 */
+static void big_shr(Big *b, int q) {
+    if (q < 0 || q >= 32 * BIG_LIMBS) {
+        memset(b, 0, sizeof(*b));
+        return;
+    }
+    int limbs = q / 32, bits = q % 32;
+    for (int i = 0; i < BIG_LIMBS; i++) {
+        uint64_t lo = i + limbs < BIG_LIMBS ? b->mag[i + limbs] : 0;
+        uint64_t hi = i + limbs + 1 < BIG_LIMBS ? b->mag[i + limbs + 1] : 0;
+        b->mag[i] = (uint32_t)(((hi << 32 | lo) >> bits));
+    }
+    if (big_is_zero(b)) b->neg = 0;
+}
+
+/* b += v */
+static void big_add(Big *b, int64_t v) {
+    Big w;
+    big_set(&w, v);
+    if (w.neg == b->neg) {
+        uint64_t carry = 0;
+        for (int i = 0; i < BIG_LIMBS; i++) {
+            uint64_t t = (uint64_t)b->mag[i] + w.mag[i] + carry;
+            b->mag[i] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        return;
+    }
+    const Big *big = b, *small = &w;
+    Big res;
+    if (big_cmp_mag(b, &w) < 0) {
+        big = &w;
+        small = b;
+    }
+    int64_t borrow = 0;
+    for (int i = 0; i < BIG_LIMBS; i++) {
+        int64_t t = (int64_t)big->mag[i] - small->mag[i] - borrow;
+        borrow = t < 0;
+        res.mag[i] = (uint32_t)(t + (borrow ? ((int64_t)1 << 32) : 0));
+    }
+    res.neg = big->neg;
+    *b = res;
+    if (big_is_zero(b)) b->neg = 0;
+}
+
+/* Is b inside a signed integer of the given width? */
+static int big_fits(const Big *b, int bits) {
+    Big lim;
+    memset(&lim, 0, sizeof(lim));
+    lim.mag[(bits - 1) / 32] = (uint32_t)1 << ((bits - 1) % 32);   /* 2^(bits-1) */
+    int c = big_cmp_mag(b, &lim);
+    return b->neg ? c <= 0 : c < 0;
+}
+
+/* b clamped to a signed integer of the given width (<= 64) */
+static int64_t big_clamp(const Big *b, int bits) {
+    int64_t max = (int64_t)((UINT64_C(1) << (bits - 1)) - 1);
+    if (!big_fits(b, bits)) return b->neg ? -max - 1 : max;
+    uint64_t m = (uint64_t)b->mag[0] | (uint64_t)b->mag[1] << 32;
+    return b->neg ? (int64_t)(0 - m) : (int64_t)m;
+}
+
+/* low bits of b in two's complement, as a signed integer of that width */
+static int64_t big_wrap(const Big *b, int bits) {
+    uint64_t m = (uint64_t)b->mag[0] | (uint64_t)b->mag[1] << 32;
+    if (b->neg) m = 0 - m;
+    if (bits < 64) {
+        m &= (UINT64_C(1) << bits) - 1;
+        if (m >> (bits - 1)) m |= ~((UINT64_C(1) << bits) - 1);
+    }
+    return (int64_t)m;
+}
+
+/* Exact Horner; *wide_ok is cleared if any product or sum leaves the
+ * accumulator width. */
+static void big_horner(Big *acc, const int64_t *coef, int degree, int64_t x, int q, int acc_bits, int *wide_ok) {
+    big_set(acc, coef[degree]);
+    *wide_ok = 1;
+    for (int k = degree - 1; k >= 0; k--) {
+        if (!big_mul(acc, x)) {
+            printf("FAIL: reference bignum too small\n");
+            *wide_ok = -1;
+            return;
+        }
+        if (!big_fits(acc, acc_bits)) *wide_ok = 0;
+        big_shr(acc, q);
+        big_add(acc, coef[k]);
+        if (!big_fits(acc, acc_bits)) *wide_ok = 0;
+    }
+}
+
+static int failures = 0;
+static long checks = 0;
+
+static void expect(const char *what, int bits, int q, int64_t got, int64_t want) {
+    checks++;
+    if (got == want || failures >= 20) return;
+    failures++;
+    printf("FAIL %s (%d-bit, q %d): got %lld, expected %lld\n", what, bits, q, (long long)got, (long long)want);
+}
+
+/* Edge values of a bits-wide type, plus powers of two around q, plus noise. */
+static int64_t pick(int bits, int q, int i) {
+    int64_t max = (int64_t)((UINT64_C(1) << (bits - 1)) - 1), min = -max - 1;
+    int64_t one = q >= 0 && q < bits - 1 ? (int64_t)1 << q : 1;
+    const int64_t edges[] = { 0, 1, -1, 2, -2, max, min, max - 1, min + 1, one, -one, one + 1, -one - 1, one - 1,
+                              max / 2, min / 2 };
+    int n = (int)(sizeof(edges) / sizeof(edges[0]));
+    if (i < n) return edges[i];
+    int64_t r = (int64_t)(rng_next() >> (64 - bits));
+    return r;
+}
+
+#define PICKS 28
+
+#define CHECK_TYPE(P, T, BITS, ACC_BITS)                                                            \
+    static void check_##P(void) {                                                                   \
+        for (int q = -2; q <= 2 * (BITS) + 1; q++) {                                                \
+            for (int i = 0; i < PICKS; i++) {                                                       \
+                for (int j = 0; j < PICKS; j++) {                                                   \
+                    T a = (T)pick(BITS, q, i), b = (T)pick(BITS, q, j);                             \
+                    Big e;                                                                          \
+                    big_set(&e, a);                                                                 \
+                    big_add(&e, b);                                                                 \
+                    expect(#P "_add", BITS, q, P##_add(a, b), big_wrap(&e, BITS));                  \
+                    expect(#P "_add_sat", BITS, q, P##_add_sat(a, b), big_clamp(&e, BITS));         \
+                    big_set(&e, a);                                                                 \
+                    big_add(&e, -(int64_t)b);                                                       \
+                    expect(#P "_sub", BITS, q, P##_sub(a, b), big_wrap(&e, BITS));                  \
+                    expect(#P "_sub_sat", BITS, q, P##_sub_sat(a, b), big_clamp(&e, BITS));         \
+                    big_set(&e, a);                                                                 \
+                    big_mul(&e, b);                                                                 \
+                    big_shr(&e, q);                                                                 \
+                    expect(#P "_mul", BITS, q, P##_mul(a, b, q), big_wrap(&e, BITS));               \
+                    expect(#P "_mul_sat", BITS, q, P##_mul_sat(a, b, q), big_clamp(&e, BITS));      \
+                }                                                                                   \
+            }                                                                                       \
+            for (int n = 0; n < 3000; n++) {                                                        \
+                int degree = (int)(rng_next() % 9);                                                 \
+                T coef[9];                                                                          \
+                int64_t wide[9];                                                                    \
+                for (int k = 0; k <= degree; k++) {                                                 \
+                    coef[k] = (T)pick(BITS, q, (int)(rng_next() % PICKS));                          \
+                    wide[k] = coef[k];                                                              \
+                }                                                                                   \
+                T x = (T)pick(BITS, q, (int)(rng_next() % PICKS));                                  \
+                Big e;                                                                              \
+                int wide_ok;                                                                        \
+                big_horner(&e, wide, degree, x, q, ACC_BITS, &wide_ok);                             \
+                if (wide_ok < 0) return;                                                            \
+                expect(#P "_horner_sat", BITS, q, P##_horner_sat(coef, degree, x, q), big_clamp(&e, BITS)); \
+                expect(#P "_horner", BITS, q, P##_horner(coef, degree, x, q),                       \
+                       wide_ok ? big_wrap(&e, BITS) : big_clamp(&e, BITS));                         \
+            }                                                                                       \
+        }                                                                                           \
+    }
+
+CHECK_TYPE(fx8, int8_t, 8, 64)
+CHECK_TYPE(fx16, int16_t, 16, 64)
+CHECK_TYPE(fx32, int32_t, 32, 128)
+
+/* The pinned types are their base type with q fixed. */
+#define CHECK_PINNED(NAME, P, T, BITS)                                                              \
+    static void check_##NAME(void) {                                                                \
+        const int q = NAME##_FRAC_BITS;                                                             \
+        for (int i = 0; i < PICKS; i++) {                                                           \
+            for (int j = 0; j < PICKS; j++) {                                                       \
+                T a = (T)pick(BITS, q, i), b = (T)pick(BITS, q, j);                                 \
+                Big e;                                                                              \
+                big_set(&e, a);                                                                     \
+                big_mul(&e, b);                                                                     \
+                big_shr(&e, q);                                                                     \
+                expect(#NAME "_mul", BITS, q, NAME##_mul(a, b), big_wrap(&e, BITS));                \
+                expect(#NAME "_mul_sat", BITS, q, NAME##_mul_sat(a, b), big_clamp(&e, BITS));       \
+                expect(#NAME "_add", BITS, q, NAME##_add(a, b), P##_add(a, b));                     \
+                expect(#NAME "_sub", BITS, q, NAME##_sub(a, b), P##_sub(a, b));                     \
+                expect(#NAME "_add_sat", BITS, q, NAME##_add_sat(a, b), P##_add_sat(a, b));         \
+                expect(#NAME "_sub_sat", BITS, q, NAME##_sub_sat(a, b), P##_sub_sat(a, b));         \
+            }                                                                                       \
+            int v = (int)pick(BITS, q, i);                                                          \
+            Big e;                                                                                  \
+            big_set(&e, v);                                                                         \
+            big_mul(&e, (int64_t)1 << q);                                                           \
+            expect(#NAME "_from_int", BITS, q, NAME##_from_int(v), big_wrap(&e, BITS));             \
+        }                                                                                           \
+        for (int n = 0; n < 3000; n++) {                                                            \
+            int degree = (int)(rng_next() % 9);                                                     \
+            T coef[9];                                                                              \
+            for (int k = 0; k <= degree; k++) coef[k] = (T)pick(BITS, q, (int)(rng_next() % PICKS)); \
+            T x = (T)pick(BITS, q, (int)(rng_next() % PICKS));                                      \
+            expect(#NAME "_horner", BITS, q, NAME##_horner(coef, degree, x), P##_horner(coef, degree, x, q)); \
+            expect(#NAME "_horner_sat", BITS, q, NAME##_horner_sat(coef, degree, x),                \
+                   P##_horner_sat(coef, degree, x, q));                                             \
+        }                                                                                           \
+    }
+
+CHECK_PINNED(q7, fx8, int8_t, 8)
+CHECK_PINNED(q8_8, fx16, int16_t, 16)
+CHECK_PINNED(q15, fx16, int16_t, 16)
+CHECK_PINNED(q16_16, fx32, int32_t, 32)
+
+int main(void) {
+    rng_seed(0xD1B54A32D192ED03ULL);
+    check_fx8();
+    check_fx16();
+    check_fx32();
+    check_q7();
+    check_q8_8();
+    check_q15();
+    check_q16_16();
+    if (failures) return 1;
+    printf("fixed_q: %ld checks ok\n", checks);
+    return 0;
+}
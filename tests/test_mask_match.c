@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mask_match.h"
+#include "org_search.h"
+#include "org_tree.h"
+#include "tests/test_rng.h"
+
+/* mask_match kernels against mask_match_scalar bit for bit, then
+ * find_match_in_org under each kernel against the original search: masks
+ * s..s+10 in order, for each every member in search order under XOR, then
+ * under AND. The orgs use a few-letter alphabet so first-byte buckets are
+ * crowded, fingerprints repeat, and AND ties between members are common. */
+
+/* Start masks around every wrap: negative, near 0, the byte boundary and past it. */
+static int random_base(void) {
+    static const int around[] = { -100000, -300, -256, -40, -11, -1, 0, 5, 245, 250, 255, 256, 300, 511, 100000 };
+    return around[rng_below(sizeof(around) / sizeof(around[0]))] + (int)rng_below(40) - 20;
+}
+
+static int check_kernels(const char *kernel) {
+    for (int n = 0; n < 200000; n++) {
+        char fp[MASK_FP_LEN];
+        uint8_t cipher[MASK_FP_LEN];
+        int base = random_base();
+        for (int i = 0; i < MASK_FP_LEN; i++) fp[i] = (char)rng_below(256);
+        /* a cipher some mask of the window (or just outside it) produces, else noise */
+        uint8_t m = (uint8_t)(base + (int)rng_below(40) - 4);
+        unsigned kind = rng_below(3);
+        for (int i = 0; i < MASK_FP_LEN; i++) {
+            uint8_t p = (uint8_t)fp[i];
+            cipher[i] = kind == 0 ? (uint8_t)(p ^ m) : kind == 1 ? (uint8_t)(p & m) : (uint8_t)rng_below(256);
+        }
+        uint32_t want_x, want_a, got_x, got_a;
+        mask_match_scalar(fp, cipher, base, &want_x, &want_a);
+        mask_match(fp, cipher, base, &got_x, &got_a);
+        if (got_x != want_x || got_a != want_a) {
+            printf("FAIL %s: base %d: xor %08x and %08x, scalar xor %08x and %08x\n", kernel, base, got_x, got_a,
+                   want_x, want_a);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* The search as ex2 first did it, one mask and operator at a time. */
+static Solution reference_search(const OrgFlat *org, const uint8_t cipher[MASK_FP_LEN], int s) {
+    Solution sol = { -1, 0, OP_XOR };
+    for (int mask = s; mask <= s + MASK_SPAN - 1; mask++) {
+        for (int use_xor = 1; use_xor >= 0; use_xor--) {
+            for (size_t i = 0; i < org->count; i++) {
+                int ok = 1;
+                for (int b = 0; b < MASK_FP_LEN && ok; b++) {
+                    uint8_t plain = (uint8_t)org->fingerprints[i][b];
+                    uint8_t enc = use_xor ? (uint8_t)(plain ^ (uint8_t)mask) : (uint8_t)(plain & (uint8_t)mask);
+                    ok = enc == cipher[b];
+                }
+                if (ok) {
+                    sol.node = (long)i;
+                    sol.mask = mask;
+                    sol.op = use_xor ? OP_XOR : OP_AND;
+                    return sol;
+                }
+            }
+        }
+    }
+    return sol;
+}
+
+/* Clean file text for an org of n members: Boss, both Hands, then supports. */
+static char *random_org_text(size_t n, size_t *len) {
+    static const char *const positions[] = { "Boss", "Left Hand", "Right Hand", "Support_Left", "Support_Right" };
+    static const char alphabet[] = "ab01\x7f\xc0\xff";
+    char *text = (char *)malloc(n * 128 + 1);
+    if (!text) return NULL;
+    size_t at = 0;
+    unsigned fp_len = 3 + rng_below(MASK_FP_LEN);
+    for (size_t i = 0; i < n; i++) {
+        char fp[MASK_FP_LEN + 4];
+        /* mostly full length, some short (zero padded in the index), a few repeats of the last one */
+        if (i == 0 || rng_below(8) != 0) {
+            fp_len = rng_below(6) == 0 ? 1 + rng_below(MASK_FP_LEN + 2) : MASK_FP_LEN;
+            for (unsigned k = 0; k < fp_len; k++) fp[k] = alphabet[rng_below(sizeof(alphabet) - 1)];
+        }
+        fp[fp_len] = '\0';
+        const char *pos = positions[i < 3 ? i : 3 + rng_below(2)];
+        at += (size_t)sprintf(text + at, "First Name: F%zu\nSecond Name: S%zu\nFingerprint: %s\nPosition: %s\n\n", i, i,
+                              fp, pos);
+    }
+    *len = at;
+    return text;
+}
+
+static int check_search(const char *kernel) {
+    for (int round = 0; round < 300; round++) {
+        size_t len;
+        char *text = random_org_text(3 + rng_below(60), &len);
+        if (!text) return 0;
+        Org tree = build_org_from_buffer(text, len);
+        free(text);
+        OrgFlat org;
+        OrgIndex ix;
+        memset(&ix, 0, sizeof(ix));
+        if (!org_flat_from_org(&tree, &org) || !org_index_build_flat(&org, &ix)) {
+            printf("FAIL %s: could not build a test org\n", kernel);
+            free_org(&tree);
+            return 0;
+        }
+        free_org(&tree);
+
+        for (int n = 0; n < 400; n++) {
+            int s = random_base();
+            uint8_t cipher[MASK_FP_LEN];
+            size_t who = rng_below((unsigned)org.count);
+            uint8_t m = (uint8_t)(s + (int)rng_below(14) - 1);
+            unsigned kind = rng_below(3);
+            for (int b = 0; b < MASK_FP_LEN; b++) {
+                uint8_t p = (uint8_t)org.fingerprints[who][b];
+                cipher[b] = kind == 0 ? (uint8_t)(p ^ m) : kind == 1 ? (uint8_t)(p & m) : (uint8_t)rng_below(4);
+            }
+            Solution want = reference_search(&org, cipher, s);
+            Solution got = find_match_in_org(&org, &ix, cipher, s);
+            if (got.node != want.node || (want.node >= 0 && (got.mask != want.mask || got.op != want.op))) {
+                printf("FAIL %s: s %d: member %ld mask %lld %s, expected member %ld mask %lld %s\n", kernel, s,
+                       got.node, got.mask, got.op, want.node, want.mask, want.op);
+                org_index_free(&ix);
+                org_flat_free(&org);
+                return 0;
+            }
+        }
+        org_index_free(&ix);
+        org_flat_free(&org);
+    }
+    return 1;
+}
+
+int main(void) {
+    rng_seed(0xC2B2AE3D27D4EB4FULL);
+    static const char *const kernels[] = { "scalar", "sse2", "avx2" };
+    int ran = 0;
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!mask_match_use(kernels[k])) {
+            printf("mask_match: %s not available, skipped\n", kernels[k]);
+            continue;
+        }
+        ran++;
+        if (!check_kernels(kernels[k]) || !check_search(kernels[k])) return 1;
+    }
+    printf("mask_match: kernels and find_match_in_org ok over %d kernels\n", ran);
+    return 0;
+}
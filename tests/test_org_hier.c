@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "org_tree.h"
+#include "tests/test_rng.h"
+
+/* OrgHier against the text parser and against itself: the role view of a
+ * clean file without Parent lines lists the members print_tree_order prints
+ * for build_org_from_buffer(), and both traversals visit every member once,
+ * parents first, on random and very deep Parent hierarchies. */
+
+static int failures = 0;
+
+static void fail(const char *what, int round) {
+    if (failures++ < 20) printf("FAIL %s (round %d)\n", what, round);
+}
+
+/* Records in any order and spelling, unknown positions and repeats included. */
+static size_t random_roles_text(char *text, size_t n) {
+    static const char *const positions[] = { "Boss", "Left Hand", "Left_Hand", "Right Hand", "Right_Hand",
+                                             "Support_Left", "Support Left", "Support_Right", "Support Right",
+                                             "Intern" };
+    size_t at = 0;
+    for (size_t i = 0; i < n; i++) {
+        at += (size_t)sprintf(text + at, "First Name: F%zu\nSecond Name: S%zu\nFingerprint: fp%u\nPosition: %s\n\n", i,
+                              i, rng_below(40), positions[rng_below(10)]);
+    }
+    return at;
+}
+
+/* Org members in print_tree_order order. */
+static size_t org_order(const Org *org, const Node **out) {
+    size_t n = 0;
+    if (!org->boss) return 0;
+    out[n++] = org->boss;
+    const Node *hands[2] = { org->left_hand, org->right_hand };
+    for (int s = 0; s < 2; s++) {
+        if (!hands[s]) continue;
+        out[n++] = hands[s];
+        for (const Node *p = hands[s]->supports_head; p; p = p->next) out[n++] = p;
+    }
+    return n;
+}
+
+static void check_roles(void) {
+    static char text[64 * 200];
+    static const Node *nodes[64];
+    static uint32_t order[64];
+    for (int round = 0; round < 3000; round++) {
+        size_t len = random_roles_text(text, rng_below(60));
+        Org org = build_org_from_buffer(text, len);
+        OrgHier h;
+        if (!org_hier_from_buffer(text, len, &h)) {
+            fail("org_hier_from_buffer", round);
+            free_org(&org);
+            return;
+        }
+        OrgHierRoles roles;
+        org_hier_roles(&h, &roles);
+        size_t want = org_order(&org, nodes);
+        size_t got = org_hier_role_order(&roles, order);
+        if (got != want) fail("role count", round);
+        for (size_t k = 0; k < got && k < want; k++) {
+            uint32_t i = order[k];
+            if (strcmp(org_hier_first(&h, i), nodes[k]->first) || strcmp(org_hier_fingerprint(&h, i), nodes[k]->fingerprint) ||
+                strcmp(org_hier_position(&h, i), nodes[k]->position)) {
+                fail("role member", round);
+                break;
+            }
+        }
+        org_hier_free(&h);
+        free_org(&org);
+    }
+}
+
+/* Every member once, each after its parent; level order by level. */
+static void check_orders(const OrgHier *h, const char *what, int round) {
+    uint32_t *order = (uint32_t *)malloc((h->count + 1) * sizeof(uint32_t));
+    uint32_t *at = (uint32_t *)malloc((h->count + 1) * sizeof(uint32_t));
+    if (!order || !at) {
+        fail("allocation", round);
+        free(order);
+        free(at);
+        return;
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        size_t n = pass ? org_hier_level_order(h, order) : org_hier_preorder(h, order);
+        if (n != h->count) {
+            fail(what, round);
+            break;
+        }
+        memset(at, 0xFF, h->count * sizeof(uint32_t));
+        for (size_t k = 0; k < n; k++) {
+            if (at[order[k]] != UINT32_MAX) fail(what, round);
+            at[order[k]] = (uint32_t)k;
+        }
+        for (size_t i = 0; i < h->count; i++) {
+            uint32_t p = h->parent[i];
+            if (p != ORG_HIER_NONE && (at[p] > at[i] || h->level[i] != h->level[p] + 1)) fail(what, round);
+        }
+        for (size_t k = 1; pass && k < n; k++) {
+            if (h->level[order[k]] < h->level[order[k - 1]]) fail(what, round);
+        }
+        /* pre-order: a subtree ends where the next member is no deeper than its root */
+        for (size_t k = 0; !pass && k + 1 < n; k++) {
+            uint32_t next = order[k + 1];
+            if (h->parent[next] != ORG_HIER_NONE && at[h->parent[next]] > k) fail(what, round);
+        }
+    }
+    free(order);
+    free(at);
+}
+
+static void check_parents(void) {
+    for (int round = 0; round < 200; round++) {
+        size_t n = 1 + rng_below(3000);
+        size_t cap = n * 96 + 1;
+        char *text = (char *)malloc(cap);
+        if (!text) return;
+        size_t len = 0;
+        for (size_t i = 0; i < n; i++) {
+            len += (size_t)sprintf(text + len, "First Name: F%zu\nSecond Name: S%zu\nFingerprint: fp%zu\nPosition: Staff\n",
+                                   i, i, i);
+            /* some roots, some unseen parents, mostly earlier members */
+            unsigned r = rng_below(20);
+            if (i > 0 && r > 1) len += (size_t)sprintf(text + len, "Parent: fp%zu\n", (size_t)rng_below((unsigned)i));
+            else if (r == 1) len += (size_t)sprintf(text + len, "Parent: fp%zu\n", i + 5);
+            text[len++] = '\n';
+        }
+        OrgHier h;
+        if (!org_hier_from_buffer(text, len, &h)) fail("org_hier_from_buffer", round);
+        else check_orders(&h, "random hierarchy order", round);
+        org_hier_free(&h);
+        free(text);
+    }
+
+    /* one chain far deeper than any call stack */
+    OrgHier h;
+    org_hier_init(&h);
+    uint32_t prev = ORG_HIER_NONE;
+    for (int i = 0; i < 2000000; i++) {
+        prev = org_hier_add(&h, prev, "F", "S", "fp", "Staff");
+        if (prev == ORG_HIER_NONE) {
+            fail("org_hier_add", 0);
+            org_hier_free(&h);
+            return;
+        }
+    }
+    if (!org_hier_seal(&h)) fail("org_hier_seal", 0);
+    else check_orders(&h, "deep chain order", 0);
+    org_hier_free(&h);
+}
+
+int main(void) {
+    rng_seed(0x2545F4914F6CDD1DULL);
+    check_roles();
+    check_parents();
+    if (failures) return 1;
+    printf("org_hier: role view and traversals ok\n");
+    return 0;
+}
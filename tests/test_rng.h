@@ -0,0 +1,28 @@
+#ifndef TEST_RNG_H
+#define TEST_RNG_H
+
+#include <stdint.h>
+
+/* xorshift64*: the one generator of the tests and bench/gen, so a seed
+ * always names the same stream. Each program seeds it once with rng_seed()
+ * before drawing; a zero seed is replaced, as the state must not be 0. */
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static inline void rng_seed(uint64_t seed) {
+    rng_state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+}
+
+static inline uint64_t rng_next(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+/* Uniform enough in 0..n-1 for n far below 2^32. */
+static inline unsigned rng_below(unsigned n) {
+    return (unsigned)((rng_next() >> 32) % n);
+}
+
+#endif // TEST_RNG_H